@@ -1,544 +1,7004 @@
-/*********************************************************************/
-/* Name: Simulation - M/M/1 Queueing System                             */
-/* Author: Richard Hurley & Brianna Drew                                */
-/* Description                                                          */
-/*    This program simulates a single server queue with exponential     */
-/* interarrival time, exponential service time, and SJF scheduling      */
-/* discipline.  The parameter to the expon funciton is scaled by 100    */
-/* to avoid problems with generating exponential variates.              */
-/* To turn the  debugging output off, change the constant DEBUG to 0    */
-/* and re-compile.                                                      */
-/*********************************************************************/
-#include <stdio.h>
-#include <math.h>
-#include <stdlib.h>
-#include <values.h>
-#include <stdbool.h>
-
-/* simulation events */
-#define ARRIVAL 0       /* arrival to queue */
-#define COMPLETE 1      /* completion of service */
-#define EOS 2           /* end of simulation */
-
-/* programming constants */
-#define FALSE 0
-#define TRUE 1
-#define DEBUG 0 /* set to 1 to turn debugging output on */
-
-/* event list - which is a doubly linked list */
-struct event_node{
-        int ev_type;                    /* event type */
-        long int ev_time;               /* time for event to occur */
-        struct Custs *cust_index;       /* customer responsible for this event */
-        struct event_node *forward;     /* forward link */
-        struct event_node *backward;    /* backward link */
-        } ;
-struct event_node *top_event;    /* points to head of event list */
-struct event_node *last_event;   /* points to end of event list */
-/* customer nodes */
-struct Custs{
-        long int arrive_time;           /* arrival time of customer */
-        long int CPU_time;              /* CPU burst time of customer - ADDED BY ME*/
-        };
-/* queue - simple linked list */
-struct Queue {
-        struct Custs *cust_index;       /* index of customer in the queue */
-        struct Queue *next;             /* points to the next node in the queue */
-        };
-
-struct Queue_struct {
-        struct Queue *q_head;     /* points to top of queue */
-        struct Queue *q_last;     /* points to bottom of queue */
-        };
-
-struct Queue_struct sjf;
-
-/* statistics gathering variables */
-float accum_resp_time;  /* accumulate customer response time */
-float num_resp_time;    /* total number of custs in system */
-
-/* input parameters */
-float iarrive_time;     /* mean interarrival time */
-float service_time;     /* mean service time */
-long int sim_length;    /* length of simulation */
-
-/* system variables */
-long int clock;         /* simulation clock */
-int busy;               /* flag indicating if server is busy */
-unsigned seed;          /* seed for random num generator */
-
-/* function declarations */
-void arrive(struct event_node *ev_num);
-void depart(struct event_node *ev_num);
-void start_service(void);
-void Gen_arrival(void);
-void Gen_departure(struct Custs *index);
-void Read_parms(void);
-void Process_statistics(void);
-void Initialize(void);
-void Insert_event(int etype, long int etime, struct Custs *custind);
-struct event_node *Remove_event(void);
-void Puton_queue(struct Queue_struct *pqueue, struct Custs *pcust);
-struct Custs *Takoff_queue(struct Queue_struct *pqueue);
-long int expon(float time);
-
-/*********************************************************************/
-/* Name: main                                                   */
-/* Description                                                  */
-/*    This function performs the main control loop of the simulation.*/
-/* It performs the following steps:                                     */
-/*    1 - call routines to initialize global variables.                 */
-/*    2 - schedules an end of simulation.                               */
-/*    3 - generates the first arrival.                          */
-/*    4 - processes the events on the event list until the end of       */
-/*        simulation event i reached.                           */
-/*    5 - frees event node after it has been processed.                 */
-/*    6 - prints out the statistics when the simulation is finished. */
-/*********************************************************************/
-void main()
-  {
-  int not_done;
-  struct event_node *event;
-  /* initialization */
-  Initialize();
-  Read_parms();
-  /* schedule an end of simulation */
-  Insert_event(EOS, sim_length, NULL);
-  /* generate first arrival */
-  Gen_arrival();
-  /* main loop to process the event list */
-  not_done = TRUE;
-  while(not_done)
-    {
-    /* get next event */
-    event = Remove_event();
-    /* update clock */
-    clock = event->ev_time;
-    /* process event type */
-    switch (event->ev_type)
-        {
-                case ARRIVAL  : arrive(event);
-                              break;
-                case COMPLETE : depart(event);
-                              break;
-                case EOS      : Process_statistics();
-                              not_done = FALSE;
-                              break;
-                default       : printf("***Error - invalid event type\n");
-                }
-        /* free event node by marking it unused */
-        free(event);
-        }
-  }
-
-/*********************************************************************/
-/* Name: arrive                                                 */
-/* Description                                                  */
-/*    This function processes an arrival to the system.                 */
-/*     It performs                                              */
-/* the followiong steps:                                                */
-/*    1 - generates the next arrival.                                   */
-/*    2 - sets the system statistics.                                   */
-/*    3 - puts the customer into the queue.                             */
-/*    4 - if the server is not busy then calls start_service.           */
-/**********************************************************************/
-void arrive(struct event_node *ev_num)
-  {
-  struct Custs *index;
-  /* generate the next arrival */
-  Gen_arrival();
-  /* set statistics gathering variable */
-  index = ev_num->cust_index;
-  index->arrive_time = clock;
-  index->CPU_time = expon(service_time);
-  /* put the customer n the queue */
-  Puton_queue(&sjf, index);
-  /* if server is not busy then start service */
-  if(!busy)
-         start_service();
-  return;
-  }
-
-/**************************************************************/
-/* Name: start_service                                        */
-/* Description                                                */
-/*    This function performs the following steps:             */
-/*    1 - removes the first customer from the queue.          */
-/*    2 - sets the server to busy.                            */
-/*    3 - schedules a departure event.                        */
-/**************************************************************/
-void start_service(void)
-  {
-  struct Custs *index;
-  /* remove the first customer from the queue */
-  index = Takoff_queue(&sjf);
-  /* set server to busy */
-  busy = TRUE;
-  /* schedule a departure event */
-  Gen_departure(index);
-  return;
-  }
-
-/********************************************************************/
-/* Name: depart                                                     */
-/* Description                                                      */
-/*    This function processes a departure from the server event. It */
-/* performs the following steps:                                    */
-/*    1 - sets the server to idle.                                  */
-/*    2 - accumulate response time statistics.                      */
-/*    3 - remove the customer from the system.                      */
-/*    4 - if the queue is not empty, then start service.            */
-/********************************************************************/
-void depart(struct event_node *ev_num)
-  {
-  struct Custs *index;
-  long int temp;
-  /* set server to idle */
-  busy = FALSE;
-  /* accumulate response time */
-  index = ev_num->cust_index;
-  temp = clock - index->arrive_time;
-#if DEBUG
-  printf(" Response time for customer is %d\n", temp);
-#endif
-  accum_resp_time += temp;  num_resp_time++;
-  /* remove customer from the system */
-  free(index);
- /* if queue is non-empty, start service */
-  if(sjf.q_head != NULL)
-         start_service();
-  return;
-  }
-
-/*********************************************************************/
-/* Name: Gen_arrival                                                 */
-/* Description                                                       */
-/*  This function will generate a new arrival. It has one parameter, */
-/* stream, which is the random number generator stream to be used.It */
-/* performs the following steps:                                     */
-/*    1 - gets a new customer.                                       */
-/*    2 - generates an exponential arrival time.                     */
-/*    3 - inserts arrival event into the event list.                 */
-/*********************************************************************/
-void Gen_arrival(void)
-  {
-  long int time;
-  struct Custs *index;
-  /* get new customer */
-  index = (struct Custs *) malloc(sizeof(struct Custs));
-  /* generate exponential interarrival time */
-  time = expon(iarrive_time);
-#if DEBUG
-  printf(" Interarrival time for customer is %d\n", time);
-  printf(" Arrival time for customer is %d\n", clock + time);
-#endif
-  /* add the event to the list */
-  Insert_event(ARRIVAL, clock+time, index);
-  return;
-  }
-
-/*********************************************************************/
-/* Name: Gen_departure                                          */
-/* Description                                                  */
-/*   This function generates a departure event from the server. It      */
-/*   has two parameters: 1) stream - random number generator stream, */
-/*   and 2) index - index of customer departing. The following  */
-/*   steps are performed:                                            */
-/*    1 - generate the service time.                                 */
-/*    2 - insert the departure event into the event list.            */
-/*********************************************************************/
-void Gen_departure(struct Custs *index)
-  {
-  long int time;
-  /* generate exponential service time */
-  time = index->CPU_time; // CHANGED BY ME
-#if DEBUG
-  printf(" Service time for customer is %d\n", time);
-  printf(" Departure time for customer is %d\n", clock + time);
-#endif
-  /* add departure event to the event list */
-  Insert_event(COMPLETE, time+clock, index);
-  return;
-  }
-
-/**************************************************************/
-/* Name: Read_parms                                           */
-/* Description                                                */
-/*    This function inputs the required simulation parameters.*/
-/**************************************************************/
-void Read_parms(void)
-  {
-  printf("   SIMULATION -- M/M/1 Queueing System\n");
-  printf("      Input the following parameters:\n");
-  printf("      mean interarrival time => ");
-  scanf("%e", &iarrive_time);
-  printf("      mean service time => ");
-  scanf("%e", &service_time);
-  printf("      length of simulation => ");
-  scanf("%ld", &sim_length);
-  printf("      seed for the random number generator => ");
-  scanf("%d", &seed);
-  /* initialize random number generator */
-  srand(seed);
-  printf(" Simulation time = %ld units\n", sim_length);
-  printf(" Simulation begins...\n");
-  }
-
-/*********************************************************************/
-/* Name: Process_statistics                                     */
-/* Description                                                  */
-/*  This function computes and prints the mean response time for the */
-/*  customers in an M/M/1 system.                               */
-/*********************************************************************/
-void Process_statistics(void)
-  {
-  float mean_resp_time;
-  /* compute mean response time */
-  mean_resp_time = accum_resp_time / (float) (100.0 * num_resp_time);
-  /* print out results */
-  printf("...Simulation ends\n");
-  printf(" Simulation results\n");
-  printf(" mean response time ---------> %-6.3f\n", mean_resp_time);
-  }
-
-/*********************************************************************/
-/* Name: Initialize                                             */
-/* Description                                                  */
-/*   This function initializes the event list, queue, customer list, */
-/*   and global variables.                                           */
-/*********************************************************************/
-void Initialize(void)
-  {
-  /* initialize the event list */
-  top_event = NULL;
-  last_event = NULL;
-  /* initialize the queue */
-  sjf.q_head = NULL;
-  sjf.q_last = NULL;
-  /* initialize the global variables */
-  clock = 0;
-  busy = FALSE;
-  accum_resp_time = 0;
-  num_resp_time = 0;
-  }
-
-/*********************************************************************/
-/* Name: Insert_event                                                   */
-/* Description                                                          */
-/*    This procedure will insert the simulation event into a doubly     */
-/*    linked queue.  The parameters are as follows:                     */
-/*     etype - type of event to be inserted.                            */
-/*     etime - the time the event will occur.                        */
-/*     custind - index of the customer associated with this event.      */
-/* The following steps are performed:                                   */
-/*     1 - get a free node and add the event information.               */
-/*     2 - insert node into the proper place in the queue.              */
-/*         2a - into an empty queue.                                    */
-/*         2b - at the top of the queue.                                */
-/*         2c - at the bottom of the queue.                             */
-/*         2d - regular insertion (someplace in the middle).            */
-/*********************************************************************/
-void Insert_event(int etype, long int etime,struct Custs *custind)
-  {
-  int not_found;
-  struct event_node *loc, *pos;
-  loc = (struct event_node *) malloc(sizeof (struct event_node));
- /* add the information to the structure */
-  loc->ev_type = etype;
-  loc->ev_time = etime;
-  loc->cust_index = custind;
-  loc->forward = NULL;
-  loc->backward = NULL;
- /* determine if the list is empty */
-  if(top_event == NULL)
-         {
-         top_event = loc;
-         last_event = loc;
-         return;
-         }
-  /* see if it belongs on top */
-   if(top_event->ev_time > etime)
-         {
-         top_event->backward = loc;
-         loc->forward = top_event;
-         top_event = loc;
-         return;
-         }
- /* see if it belongs at the bottom */
-  if(last_event->ev_time <= etime)
-         {
-         last_event->forward = loc;
-         loc->backward = last_event;
-         last_event = loc;
-         return;
-         }
- /* it belongs somewhere in the middle so find its place */
-  not_found = TRUE;
-  pos = top_event;
-  while(pos != NULL && not_found)
-         {
-        if(pos->ev_time > etime)
-                not_found = FALSE;
-         else
-                pos = pos->forward;
-         }
-  /* check to see if we found something as we should have */
-  if(not_found)
-         {
-         printf(" ***Error - problems in insert event routine***\n");
-         return;
-         }
-  /* add node to appropriate place */
-  loc->forward = pos;
-  loc->backward = pos->backward;
-  (pos->backward)->forward = loc;
-  pos->backward = loc;
-  return;
-}
-
-/*********************************************************************/
-/* Name: Remove_event                                           */
-/* Description                                                  */
-/*    This function returns the next event from the head of the */
-/* event list.  It checks for a special case where there is only        */
-/* one event so the event list can be marked empty.                     */
-/*********************************************************************/
-struct event_node *Remove_event(void)
-  {
-  struct event_node *ev_ptr;
-  /* check to see if event list is empty */
-  if(last_event == NULL)
-         {
-         printf(" ***Error - Event list underflow***\n");
-         return(NULL);
-         }
-  /* remove top element */
-  ev_ptr = top_event;
-  /* see if it was the only event - special case to mark empty */
-  if(top_event == last_event)
-         {
-         top_event = NULL;
-         last_event = NULL;
-         return(ev_ptr);
-         }
-  /* event list has more than one element so just relink */
-  top_event = top_event->forward;
-  top_event->backward = NULL;
-  ev_ptr->forward = NULL;
-  return(ev_ptr);
-  }
-
-/*********************************************************************/
-/* Name: Puton_queue                                            */
-/* Description                                                          */
-/*    This procedure inserts a customer at the end of the given         */
-/* queue. The parameters are as follows:                        */
-/*     pqueue - pointer to the queue.                                   */
-/*     pcust - index of the customer to be inserted.                    */
-/* The procedure performs the following steps:                          */
-/*     1 - get a free node for the customer.                    */
-/*     2 - insert the node at the end of the queue.              */
-/*         2a - into an empty queue                             */
-/*         2b - normal insertion                                */
-/*********************************************************************/
-void Puton_queue(struct Queue_struct *pqueue, struct Custs *pcust)
-  {
-  struct Queue *newnode;
-  /* get an new node */
-  newnode = (struct Queue *) malloc(sizeof(struct Queue));
-  /* now loc is the index of a free node in queue */
-  /* put information in the node */
-  newnode->cust_index = pcust;
-  newnode->next = NULL;
- /* check to see if the queue is initially empty */
-  if(pqueue->q_last == NULL)
-         {
-         /* if so, add to queue as head and last node */
-         pqueue->q_head = newnode;
-         pqueue->q_last = newnode;
-         return;
-         }
-
-  /* if newnode's burst time is less than the first node's in queue, add to beginning of queue - ADDED BY ME */
-  if(newnode->cust_index->CPU_time < pqueue->q_head->cust_index->CPU_time){
-      newnode->next = pqueue->q_head;
-      pqueue->q_head = newnode;
-      return;
-  }
-
-  /* if newnode's burst time is greater than the last node's in the queue, add to end of queue - ADDED BY ME */
-  if(newnode->cust_index->CPU_time >= pqueue->q_last->cust_index->CPU_time){
-      pqueue->q_last->next = newnode;
-      pqueue->q_last = newnode;
-      return;
-  }
-  /* create new Queue structures to represent the nodes which the new node will be inserted in between in the queue - ADDED BY ME */
-  struct Queue *previous_node;
-  struct Queue *following_node;
-  previous_node = pqueue->q_head;
-  following_node = pqueue->q_head->next;
-  bool searching = true;
-
-  /* traverse the queue and when there is a node in which the new node has a smaller CPU time than, insert the new node before that node in the queue - ADDED BY ME*/
-  do{
-      if(newnode->cust_index->CPU_time < following_node->cust_index->CPU_time){
-          newnode->next = previous_node->next;
-          previous_node->next = newnode;
-          return;
-      }
-      previous_node = previous_node->next;
-      following_node = following_node->next;
-  }while(searching);
-  }
-
-/*********************************************************************/
-/* Name: Takoff_queue                                                   */
-/* Description                                                          */
-/*    This function returns the index into the customer array of        */
-/* the head element of the given queue. The parameters are:             */
-/*     pqueue -  pointer to the given queue.                            */
-/* If the customer removed is the last remaining customer, the  */
-/* queue is marked empty.                                       */
-/*********************************************************************/
-struct Custs *Takoff_queue(struct Queue_struct *pqueue)
-  {
-  struct Queue *loc;
-  struct Custs *index;
-  /* check if the queue is empty */
-  if(pqueue->q_head == NULL)
-         {
-         printf(" ***Error - queue underflow***\n");
-         return(NULL);
-         }
-  /* remove top element from queue */
-  loc = pqueue->q_head;
-  /* get customer index */
-  index = loc->cust_index;
- /* check if queue now empty and relink */
-  if(pqueue->q_head == pqueue->q_last)
-         {
-         pqueue->q_last = NULL;
-         pqueue->q_head = NULL;
-         return(index);
-         }
-  /* otherwise just relink */
-  pqueue->q_head = loc->next;
-  free(loc);
-  return(index);
-  }
-
-/*********************************************************************/
-/* Name: expon                                                          */
-/* Description                                                          */
-/*    This function is used to generate an exponential variate given */
-/* the mean time.                                                       */
-/*********************************************************************/
-long int expon(float time)
-  {
-  long int val;
-  double temp;
-  time = time * 100;
-  temp = 1.0 - (rand()/ (float) RAND_MAX);
-  val = ceil(-time * log((double) temp));
-  return(val);
-  }
+/*********************************************************************/
+/* Name: Simulation - M/M/1 Queueing System                             */
+/* Author: Richard Hurley & Brianna Drew                                */
+/* Description                                                          */
+/*    This program simulates a single server queue with exponential     */
+/* interarrival time, exponential service time, and SJF scheduling      */
+/* discipline.  The parameter to the expon funciton is scaled by 100    */
+/* to avoid problems with generating exponential variates.              */
+/* Random numbers come from separate arrival and service streams keyed  */
+/* by customer number, so a given seed produces the same workload       */
+/* whatever order the events are processed in.                          */
+/* To turn the  debugging output off, change the constant DEBUG to 0    */
+/* and re-compile.                                                      */
+/* Command line options:                                                */
+/*    -b file  draw service times from an empirical distribution file   */
+/*    -a n     run n antithetic replication pairs                       */
+/*    -r file  take time varying arrival rates from a rate profile file */
+/*    -m file  use a Markov-modulated Poisson arrival process           */
+/*    -p list  response time percentiles to report, e.g. 50,99,99.9    */
+/*    -e rel   stop once the 95% CI half-width is below rel * mean      */
+/*    -x len   longest run allowed with -e (default 100 * length)       */
+/*    -A       print the analytic M/G/1 SJF mean response time and stop */
+/*    -V tol   relative tolerance of the analytic check (default 0.05)  */
+/*    -n reps  run reps independent replications on a pool of threads   */
+/*    -t num   threads for -n, -S, -P and -W (default one per processor)*/
+/*    -S file  run every point of a sweep file on a work-stealing pool  */
+/*    -o file  file the sweep results are written to (default stdout)   */
+/*    -L       run the -n replications LANE_COUNT at a time in lockstep */
+/*             (scalar code, keeping only what -n reports)             */
+/*    -K num   run the -S sweep in num worker processes instead         */
+/*    -M mb    memory each worker process may add to what it inherits   */
+/*    -N file  simulate a network of SJF nodes from a network file      */
+/*             (the length and seed are still read, the other two are  */
+/*             ignored)                                                 */
+/*    -P       run the -N network on the conservative parallel engine   */
+/*    -W       run the -N network on the optimistic Time Warp engine    */
+/*    -Y place pin the -n threads to processors, filling one NUMA node  */
+/*             at a time (compact) or dealing them across the nodes     */
+/*             (spread)                                                 */
+/*    -G       draw the arrival and burst variates of a single run on a */
+/*             second thread, which passes them on through a ring      */
+/* The four parameters (mean interarrival time, mean service time,      */
+/* length and seed) may follow the options instead of being typed in.  */
+/* Compile with -pthread.                                               */
+/* All state of a run lives in a Sim_context made by Sim_create, so     */
+/* several runs can share one Sim_parms and proceed at the same time.   */
+/* Compile with -DSJF_NO_MAIN to embed the simulator in another program.*/
+/*********************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <values.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sched.h>
+
+/* simulation events */
+#define ARRIVAL 0       /* arrival to queue */
+#define COMPLETE 1      /* completion of service */
+#define EOS 2           /* end of simulation */
+
+/* random number streams */
+#define ARRIVAL_STREAM 1        /* interarrival times */
+#define SERVICE_STREAM 2        /* CPU burst times */
+
+/* programming constants */
+#define FALSE 0
+#define TRUE 1
+#define DEBUG 0 /* set to 1 to turn debugging output on */
+#define EMP_BINS 4096   /* bins used when building a distribution from raw samples */
+#define LINE_LEN 256    /* longest line accepted in an input file */
+#define MAX_PCT 16      /* most percentiles that can be reported */
+#define LANE_COUNT 8    /* replications advanced in lockstep by -L */
+#define REP_BLOCKS 256  /* blocks the -n replications are reduced in */
+#define NUMA_MAX_NODES 64       /* most NUMA nodes looked for */
+#define PLACE_NONE 0    /* thread placement policies of -Y */
+#define PLACE_COMPACT 1
+#define PLACE_SPREAD 2
+#define POOL_EVENT 0    /* kinds of record kept in a node pool */
+#define POOL_QUEUE 1
+#define POOL_CUST 2
+#define POOL_CONTEXT 3
+#define POOL_KINDS 4
+#define POOL_SLAB 65536 /* bytes a node pool maps at a time */
+#define SHARD_TRIES 3   /* times a sweep point may kill its worker process */
+#define SHARD_POLL 10   /* milliseconds between looks for finished sweep points */
+
+/* state of a sweep point in the shared region, or the pid running it */
+#define SLOT_FREE 0
+#define SLOT_DONE -1
+#define SLOT_FAILED -2
+
+/* network model */
+#define NET_ARRIVAL_STREAM 3    /* external interarrival times */
+#define NET_SERVICE_STREAM 4    /* service times, keyed by job and hop */
+#define NET_ROUTE_STREAM 5      /* routing choices, keyed by job and hop */
+#define NET_DEPART 0    /* event types, in the order they are handled */
+#define NET_ARRIVE 1    /*    within a time step */
+#define NET_EXTERNAL 2
+#define NET_START 3
+#define NET_RING 1024   /* messages each channel holds, a power of 2 */
+#define NET_MAX_NODES 4096      /* most nodes in a network */
+#define NET_MAX_ROUTES 64       /* most routes out of a node */
+#define TW_BATCH 256    /* events a Time Warp thread may handle in each GVT round */
+#define TW_IDLE 0       /* phases of a Time Warp GVT round */
+#define TW_JOIN 1
+#define TW_REPORT 2
+#define FEED_RING 8192  /* variate pairs the -G ring holds, a power of 2 */
+#define FEED_BATCH 512  /* pairs the -G producer draws at a time */
+
+/* log-linear (HDR) histogram layout: values below HDR_SUB are exact, */
+/* above that each power of 2 has HDR_SUB/2 buckets, so the relative  */
+/* error of a reported value is at most 2/HDR_SUB                     */
+#define HDR_SUB_BITS 7
+#define HDR_SUB (1 << HDR_SUB_BITS)
+#define HDR_HALF (HDR_SUB / 2)
+#define HDR_BUCKETS (HDR_SUB + (64 - HDR_SUB_BITS) * HDR_HALF)
+
+/* t-digest size: the compression bounds the number of centroids kept */
+#define TD_COMPRESSION 200
+#define TD_CENTROIDS (TD_COMPRESSION + 10)
+#define TD_BUFFER 256   /* values collected before they are merged in */
+
+/* batch means - batches are merged in pairs when the table fills */
+#define MAX_BATCHES 64  /* batch means kept */
+#define FIRST_BATCH 32  /* customers in a batch at the start of a run */
+#define MIN_BATCHES 30  /* batches needed before the stopping rule is tried */
+#define MAX_CORR 0.2    /* largest lag 1 correlation of batch means accepted */
+
+/* MSER warm-up detection - batches of 5, merged in pairs when full */
+#define MSER_BATCH 5    /* customers in a batch at the start of a run */
+#define MSER_MAX 4096   /* batch means kept */
+
+/* job size classes - class k holds bursts of 2^k to 2^(k+1)-1 ticks */
+#define NUM_CLASSES 40
+#define CLASS_PCT 0.99  /* tail quantile reported for each class */
+
+/* analytic solution */
+#define ANALYTIC_TOL 1e-9       /* error allowed in the exponential integral */
+#define ANALYTIC_DEPTH 40       /* deepest the adaptive Simpson rule may split */
+
+/* event list - which is a doubly linked list */
+struct event_node{
+        int ev_type;                    /* event type */
+        long int ev_time;               /* time for event to occur */
+        struct Custs *cust_index;       /* customer responsible for this event */
+        struct event_node *forward;     /* forward link */
+        struct event_node *backward;    /* backward link */
+        } ;
+/* customer nodes */
+struct Custs{
+        long int arrive_time;           /* arrival time of customer */
+        long int CPU_time;              /* CPU burst time of customer - ADDED BY ME*/
+        unsigned long int cust_num;     /* customer number, keys its random numbers */
+        long int start_time;            /* time the customer entered service */
+        long int interarrival;          /* time since the previous arrival */
+        };
+/* queue - simple linked list */
+struct Queue {
+        struct Custs *cust_index;       /* index of customer in the queue */
+        struct Queue *next;             /* points to the next node in the queue */
+        };
+
+struct Queue_struct {
+        struct Queue *q_head;     /* points to top of queue */
+        struct Queue *q_last;     /* points to bottom of queue */
+        struct Node_pool *pool;   /* where its nodes come from, NULL for malloc */
+        };
+
+/* empirical distribution - Walker alias table */
+struct Emp_dist {
+        int nbins;                      /* number of bins in the table */
+        int raw;                        /* TRUE if bins were built from raw samples */
+        double *left;                   /* lower edge of each bin (raw samples) */
+        double *width;                  /* width of each bin (raw samples) */
+        double *value;                  /* value of each bin (histogram input) */
+        double *prob;                   /* probability of keeping bin i */
+        int *alias;                     /* bin chosen instead of bin i */
+        double mean;                    /* mean of the distribution */
+        };
+
+/* arrival rate profile - piecewise constant or linear, repeating */
+struct Rate_profile {
+        int nseg;                       /* number of segments in one period */
+        int linear;                     /* TRUE if the rate is interpolated */
+        double *start;                  /* segment start times, start[nseg] = period */
+        double *rate;                   /* rate at each segment start */
+        double *major;                  /* majorant (largest rate) of each segment */
+        double mean_rate;               /* average rate over a period */
+        };
+
+/* Markov-modulated Poisson arrival process */
+struct Mmpp {
+        int nphase;                     /* number of phases */
+        double *rate;                   /* arrival rate in each phase */
+        double *total;                  /* arrival rate plus rate of leaving each phase */
+        double *cum;                    /* row i: cumulative rates of moving i -> j */
+        double mean_rate;               /* long run arrival rate */
+        };
+
+/* parameter sweep - a grid of axis values or a list of points */
+struct Sweep {
+        int grid;                       /* TRUE for a grid, FALSE for a list */
+        int naxis[3];                   /* values on the iarrive, service, seed axes */
+        double *axis[3];                /* the values, an empty axis keeps the input */
+        long int npoint;                /* points in a list */
+        double *point;                  /* list: iarrive, service, seed of each point */
+        };
+
+/* streaming statistics - count, mean, variance, min and max */
+struct Stat {
+        unsigned long long count;       /* number of observations */
+        double sum;                     /* compensated (Kahan) sum */
+        double comp;                    /* running compensation of sum */
+        double mean;                    /* running (Welford) mean */
+        double m2;                      /* sum of squared deviations from mean */
+        double min;                     /* smallest observation */
+        double max;                     /* largest observation */
+        };
+
+/* histogram of non-negative integer values */
+struct Hdr_hist {
+        unsigned long long count;       /* number of values recorded */
+        unsigned long long bucket[HDR_BUCKETS]; /* count of values in each bucket */
+        };
+
+/* P-square estimator of one quantile - five markers */
+struct P2_quant {
+        double p;                       /* quantile being estimated (0-1) */
+        unsigned long long count;       /* number of observations */
+        double q[5];                    /* marker heights */
+        double n[5];                    /* marker positions */
+        double want[5];                 /* desired marker positions */
+        };
+
+/* t-digest - weighted centroids, dense at the tails */
+struct Centroid {
+        double mean;                    /* mean of the values in the centroid */
+        double weight;                  /* number of values in the centroid */
+        };
+struct T_digest {
+        int ncent;                      /* centroids in use */
+        int nbuf;                       /* buffered values not yet merged */
+        double total;                   /* total weight of the digest */
+        double min;                     /* smallest value added */
+        double max;                     /* largest value added */
+        struct Centroid cent[TD_CENTROIDS];     /* merged centroids, sorted */
+        struct Centroid buf[TD_BUFFER];         /* values waiting to be merged */
+        };
+
+/* batch means of an output series */
+struct Batch_means {
+        long int size;                  /* observations in each batch */
+        long int nbatch;                /* complete batches */
+        long int inbatch;               /* observations in the current batch */
+        double cur;                     /* sum of the current batch */
+        double mean[MAX_BATCHES];       /* means of the complete batches */
+        };
+
+/* MSER warm-up detection - batch means in time order */
+struct Mser {
+        long int size;                  /* observations in each batch */
+        long int nbatch;                /* complete batches */
+        long int inbatch;               /* observations in the current batch */
+        double cur;                     /* sum of the current batch */
+        double mean[MSER_MAX];          /* means of the complete batches */
+        long int end_time[MSER_MAX];    /* clock when each batch completed */
+        };
+
+/* time-weighted statistics - areas under the state of the system */
+struct Time_avg {
+        long int last;                  /* time of the last update */
+        double queue;                   /* area under number in queue */
+        double system;                  /* area under number in system */
+        double busy;                    /* area under server busy flag */
+        double work;                    /* area under unfinished work */
+        };
+
+/* statistics of one job size class */
+struct Size_class {
+        struct Stat resp;               /* response times */
+        struct Stat wait;               /* waiting times */
+        struct Stat slowdown;           /* response time / burst time */
+        struct P2_quant tail;           /* tail quantile of response time */
+        };
+
+/* model parameters - read once, shared read-only by every run */
+struct Sim_parms {
+        float iarrive_time;             /* mean interarrival time */
+        float service_time;             /* mean service time */
+        long int sim_length;            /* length of simulation */
+        unsigned seed;                  /* seed for random num generator */
+        struct Emp_dist *burst_dist;    /* service time distribution, NULL for exponential */
+        struct Rate_profile *rate_profile;      /* arrival rates, NULL for constant rate */
+        struct Mmpp *mmpp;              /* modulated arrivals, NULL for plain Poisson */
+        double pct_list[MAX_PCT];       /* percentiles to report */
+        int num_pct;                    /* number of percentiles to report */
+        double seq_target;              /* relative CI half-width that ends a run, 0 for off */
+        long int max_length;            /* longest run allowed by the stopping rule */
+        long int num_pairs;             /* antithetic replication pairs to run, 0 for one run */
+        long int num_reps;              /* independent replications to run, 0 for one run */
+        int num_threads;                /* worker threads for -n, 0 for one per processor */
+        int parms_given;                /* TRUE if the parameters came from the command line */
+        struct Sweep *sweep;            /* points to sweep, NULL for no sweep */
+        char *sweep_out;                /* file the sweep results go to, NULL for stdout */
+        int lockstep;                   /* TRUE to run -n replications in lockstep lanes */
+        int num_procs;                  /* worker processes for -S, 0 to use threads */
+        long int mem_limit;             /* address space a worker process may add, MB */
+        struct Net_model *network;      /* network to simulate, NULL for one node */
+        int net_parallel;               /* TRUE to use the conservative parallel engine */
+        int net_timewarp;               /* TRUE to use the optimistic Time Warp engine */
+        int placement;                  /* PLACE_NONE, PLACE_COMPACT or PLACE_SPREAD */
+        int pipeline;                   /* TRUE to draw the variates on a second thread */
+        int analytic_only;              /* TRUE to print the analytic solution and stop */
+        double check_tol;               /* relative tolerance of the analytic check */
+        };
+
+/* simulation context - everything one run changes, so runs can coexist */
+struct Sim_context {
+        struct Sim_parms *parms;        /* model parameters of this run */
+        struct Node_pool *pool;         /* where its records come from, NULL for malloc */
+        struct Var_feed *feed;          /* ring the variates come from, NULL to draw them */
+
+        /* system variables */
+        long int clock;                 /* simulation clock */
+        int busy;                       /* flag indicating if server is busy */
+        struct event_node *top_event;   /* points to head of event list */
+        struct event_node *last_event;  /* points to end of event list */
+        struct Queue_struct sjf;        /* customers waiting for the server */
+        unsigned long int next_cust;    /* number given to the next customer */
+        unsigned long int replication;  /* replication number, selects the substream */
+        int antithetic;                 /* TRUE to use 1-U in place of every uniform U */
+        double last_arrival;            /* exact time of the latest arrival (profile arrivals) */
+        int prof_seg;                   /* profile segment containing last_arrival */
+        double prof_base;               /* time at which the current profile period began */
+        int mmpp_phase;                 /* current phase of the arrival process */
+        long int prev_arrival;          /* clock at the previous arrival */
+        double iat_sum;                 /* interarrival times generated, next_cust of them */
+        double burst_sum;               /* burst times generated, likewise */
+        int stop_scheduled;             /* TRUE once the stopping rule has scheduled EOS */
+
+        /* statistics gathering variables */
+        struct Stat resp_stat;          /* customer response times */
+        struct Size_class size_class[NUM_CLASSES];      /* statistics by burst size */
+        struct Stat wait_stat;          /* customer waiting times in the queue */
+        struct Stat serv_stat;          /* customer service times */
+        struct Hdr_hist wait_hist;      /* histogram of waiting times */
+        struct Stat busy_stat;          /* busy period lengths */
+        struct Stat idle_stat;          /* idle period lengths */
+        struct Hdr_hist busy_hist;      /* histogram of busy period lengths */
+        struct Hdr_hist idle_hist;      /* histogram of idle period lengths */
+        long int period_start;          /* time the current busy or idle period began */
+        struct Mser resp_mser;          /* response times for warm-up detection */
+        struct Batch_means resp_batch;  /* batch means of customer response times */
+        struct Batch_means burst_batch; /* batch means of burst times, in step with resp_batch */
+        struct Batch_means iat_batch;   /* batch means of interarrival times, likewise */
+        struct Hdr_hist resp_hist;      /* histogram of customer response times */
+        struct P2_quant resp_p2[MAX_PCT];       /* P-square estimate of each percentile */
+        struct T_digest resp_td;        /* t-digest of customer response times */
+        struct Time_avg tavg;           /* time-weighted queue, system, busy and work */
+        long int num_in_queue;          /* customers waiting in the queue */
+        double unfinished;              /* unfinished work in the system at tavg.last */
+        unsigned long long num_arrivals;        /* customers that have arrived */
+        };
+
+/* one thread of the replication runner - touched only by its thread */
+/* until the thread has been joined                                   */
+struct Rep_worker {
+        struct Sim_parms *parms;        /* model parameters, shared read-only */
+        pthread_t thread;               /* thread running Replication_worker */
+        int index;                      /* this worker runs blocks (lane groups with */
+        int stride;                     /*    -L) index, index + stride ... */
+        long int reps;                  /* replications in the whole run */
+        double *resp;                   /* mean response time of each replication */
+        double *burst;                  /* mean burst time of each replication */
+        double *iat;                    /* mean interarrival time of each replication */
+        int failed;                     /* TRUE if a context could not be created */
+        struct Hdr_hist hist;           /* response times of this worker's runs */
+        long int nblock;                /* blocks the replications are split into */
+        struct Rep_block *block;        /* sketches of each block, shared */
+        int cpu;                        /* processor it is pinned to, -1 for none */
+        int node;                       /* NUMA node of that processor */
+        long int done;                  /* replications it has run */
+        };
+
+/* sketches of one block of consecutive replications - blocks do not */
+/* depend on the number of threads, and are merged in order          */
+struct Rep_block {
+        struct P2_quant p2[MAX_PCT];    /* P-square estimates of the block's runs */
+        struct T_digest td;             /* t-digest of the block's runs */
+        };
+
+/* double-ended queue of sweep points - the owner takes from the */
+/* front, idle workers steal from the back                        */
+struct Sweep_deque {
+        pthread_mutex_t lock;           /* guards front and back */
+        long int *item;                 /* indices of the points */
+        long int front;                 /* next point the owner runs */
+        long int back;                  /* one past the last point */
+        };
+
+/* results of one sweep point */
+struct Sweep_result {
+        double util;                    /* measured server utilization */
+        unsigned long long customers;   /* customers served */
+        double mean;                    /* mean response time */
+        double half;                    /* batch means 95% CI half-width */
+        double pct[MAX_PCT];            /* requested response time percentiles */
+        double analytic;                /* analytic mean, -1 if unknown */
+        };
+
+/* result slot of one sweep point in the region shared by the processes */
+struct Shard_slot {
+        int state;                      /* SLOT_FREE, SLOT_DONE, SLOT_FAILED or owner's pid */
+        int tries;                      /* workers the point has killed, parent only */
+        struct Sweep_result res;        /* results, valid once SLOT_DONE */
+        struct Hdr_hist hist;           /* response time histogram of the point */
+        };
+
+/* region shared by the sweep processes - zero filled, so every */
+/* point starts SLOT_FREE                                        */
+struct Shard_region {
+        long int cursor;                /* first point never handed out */
+        long int npoint;                /* points in the sweep */
+        struct Shard_slot slot[];       /* one per point */
+        };
+
+/* one thread of the sweep engine */
+struct Sweep_worker {
+        struct Sim_parms *parms;        /* parameters common to every point */
+        pthread_t thread;               /* thread running Sweep_worker */
+        int index;                      /* this worker's deque */
+        int nworker;                    /* number of workers */
+        struct Sweep_deque *deque;      /* every worker's deque */
+        double *point;                  /* iarrive, service, seed of each point */
+        long int npoint;                /* number of points */
+        FILE *out;                      /* results file, shared */
+        FILE *progress;                 /* where finished points are noted */
+        pthread_mutex_t *out_lock;      /* guards out, res, ready and next_out */
+        struct Sweep_result *res;       /* results of each point */
+        char *ready;                    /* TRUE once a point's results are in */
+        long int *next_out;             /* first point not yet written */
+        long int done;                  /* points this worker has run */
+        long int steals;                /* points it took from other workers */
+        };
+
+/* customer waiting in a lockstep lane */
+struct Lane_job {
+        long int burst;                 /* CPU time */
+        unsigned long int cust;         /* customer number */
+        long int arrive;                /* arrival time */
+        };
+
+/* SJF queue of one lockstep lane - a binary heap ordered by burst */
+/* and then customer number, so equal bursts leave in arrival order */
+struct Lane_queue {
+        long int n;                     /* customers in the queue */
+        long int size;                  /* room in job */
+        struct Lane_job *job;           /* the heap */
+        };
+
+/* LANE_COUNT replications run in lockstep, one per lane, kept as */
+/* structure of arrays so each step is a loop over the lanes       */
+struct Lanes {
+        unsigned long int rep[LANE_COUNT];      /* replication of each lane */
+        int active[LANE_COUNT];         /* lane mask - FALSE once the lane has ended */
+        int dep[LANE_COUNT];            /* TRUE if the lane's next event is a departure */
+        long int clock[LANE_COUNT];     /* simulation clock */
+        long int seq[LANE_COUNT];       /* events scheduled so far, orders ties */
+        long int next_arr[LANE_COUNT];  /* time of the next arrival */
+        long int arr_seq[LANE_COUNT];   /* when the next arrival was scheduled */
+        unsigned long int arr_cust[LANE_COUNT]; /* customer of the next arrival */
+        long int next_dep[LANE_COUNT];  /* time of the next departure, MAXLONG if idle */
+        long int dep_seq[LANE_COUNT];   /* when the next departure was scheduled */
+        long int serv_arrive[LANE_COUNT];       /* arrival time of the customer in service */
+        long int next_cpu[LANE_COUNT];  /* burst of the next arrival */
+        double iat_sum[LANE_COUNT];     /* interarrival times generated, arr_cust + 1 */
+        double burst_sum[LANE_COUNT];   /* burst times generated, likewise */
+        unsigned long long resp_count[LANE_COUNT];      /* customers served */
+        unsigned long long resp_sum[LANE_COUNT];        /* total response time */
+        struct Lane_queue queue[LANE_COUNT];    /* SJF queue of each lane */
+        };
+
+/* network of SJF nodes - read from a network file, shared read-only */
+struct Net_model {
+        int nnode;                      /* number of nodes */
+        double *service;                /* mean service time of each node */
+        double *min_service;            /* shortest service time of each node */
+        long int *min_ticks;            /* shortest service time in ticks */
+        long int *lookahead;            /* earliest a job can leave after it starts */
+        double *iarrive;                /* mean external interarrival time, 0 for none */
+        int *nroute;                    /* routes out of each node */
+        int **dest;                     /* node each route leads to */
+        double **cum;                   /* cumulative probability of each route */
+        };
+
+/* a job moving through the network */
+struct Net_job {
+        unsigned long long id;          /* origin node << 40 | job number there */
+        int hop;                        /* nodes finished so far, -1 in a null message */
+        long int entry;                 /* time the job entered the network */
+        long int arrive;                /* time it arrived at its current node */
+        long int burst;                 /* service time at its current node */
+        };
+
+/* network event - ordered by time, then type, node and job id */
+struct Net_event {
+        long int time;                  /* time of the event */
+        int type;                       /* NET_DEPART ... NET_START */
+        int node;                       /* node the event happens at */
+        struct Net_job job;             /* job arriving or departing */
+        };
+
+/* cancelled entry of a heap - an event, or a job's id and hop with */
+/* its arrival as the time and the rest zero                         */
+struct Net_dead {
+        struct Net_event ev;            /* what was cancelled */
+        long int count;                 /* copies cancelled, 0 if the slot is free */
+        };
+
+/* entries cancelled but left in a heap until they reach the top - */
+/* a hash table with open addressing, empty unless Time Warp undoes */
+/* something                                                        */
+struct Net_cancel {
+        long int size;                  /* slots, a power of 2, 0 before the first */
+        long int used;                  /* slots in use */
+        struct Net_dead *dead;          /* the table */
+        };
+
+/* binary heap of network events */
+struct Net_heap {
+        long int n;                     /* events in the heap */
+        long int size;                  /* room in ev */
+        struct Net_event *ev;           /* the heap */
+        struct Net_cancel cancel;       /* events cancelled but still in ev */
+        };
+
+/* SJF queue of a network node - binary heap ordered by burst, then id */
+struct Net_queue {
+        long int n;                     /* jobs in the queue */
+        long int size;                  /* room in job */
+        struct Net_job *job;            /* the heap */
+        struct Net_cancel cancel;       /* jobs cancelled but still in job */
+        };
+
+/* state and statistics of a network node apart from its queue -   */
+/* small enough to copy whole when an event may need undoing        */
+struct Net_state {
+        int busy;                       /* TRUE while a job is in service */
+        int start_pending;              /* TRUE once a NET_START is scheduled */
+        struct Net_job serving;         /* job in service */
+        long int depart_time;           /* when it leaves */
+        unsigned long long next_ext;    /* number of the next external job */
+        unsigned long long served;      /* jobs that finished service */
+        unsigned long long sojourn_sum; /* their total time at the node */
+        unsigned long long started;     /* jobs that started service */
+        unsigned long long wait_sum;    /* their total waiting time */
+        unsigned long long busy_ticks;  /* server busy time before the end */
+        unsigned long long exits;       /* jobs that left the network here */
+        unsigned long long resp_sum;    /* their total time in the network */
+        };
+
+/* one network node */
+struct Net_node {
+        int index;                      /* number of the node */
+        struct Net_state st;            /* its state and statistics */
+        struct Net_queue queue;         /* jobs waiting for the server */
+        struct Hdr_hist resp_hist;      /* network times of jobs leaving here */
+        };
+
+/* what handling one node event produced */
+struct Net_out {
+        int nlocal;                     /* events the node schedules for itself */
+        struct Net_event local[2];      /* the events */
+        int dest;                       /* node a departing job moves to, -1 for none */
+        struct Net_event msg;           /* its arrival there */
+        long int resp;                  /* network time of a job leaving, else -1 */
+        };
+
+/* message between logical processes - a job, or a null message whose */
+/* time is a bound on the time of anything sent later                 */
+struct Net_msg {
+        long int time;                  /* arrival time, or the bound */
+        struct Net_job job;             /* the job, hop -1 for a null message */
+        };
+
+/* lock-free single producer, single consumer ring of messages */
+struct Spsc_ring {
+        struct Net_msg buf[NET_RING];   /* the messages */
+        unsigned long head __attribute__((aligned(64)));       /* next to read, consumer only */
+        unsigned long tail __attribute__((aligned(64)));       /* next to write, producer only */
+        };
+
+/* interarrival and CPU burst time of one customer */
+struct Variate {
+        long int iarrive;               /* time to the next customer's arrival */
+        long int burst;                 /* CPU time the customer needs */
+        };
+
+/* variates of a single run, drawn ahead by a producer thread into a */
+/* lock-free single producer, single consumer ring (-G)              */
+struct Var_feed {
+        struct Sim_parms *parms;        /* model parameters, shared read-only */
+        unsigned long int replication;  /* substream of the run */
+        int antithetic;                 /* TRUE for the antithetic stream */
+        pthread_t thread;               /* thread running Feed_producer */
+        struct Variate buf[FEED_RING];  /* the variates, customer by customer */
+        unsigned long head __attribute__((aligned(64)));       /* next to read, consumer only */
+        unsigned long tail_seen;        /* tail as the consumer last read it */
+        unsigned long tail __attribute__((aligned(64)));       /* next to write, producer only */
+        unsigned long head_seen;        /* head as the producer last read it */
+        int stop;                       /* set by the consumer to end the producer */
+        };
+
+/* message waiting for room on a full channel */
+struct Net_held {
+        int dest;                       /* node it is for */
+        struct Net_msg msg;             /* the message */
+        };
+
+/* logical process of the conservative engine - one node, stepped by */
+/* one thread of the pool                                            */
+struct Net_lp {
+        struct Net_model *net;          /* network, shared read-only */
+        struct Sim_parms *parms;        /* length and seed, shared read-only */
+        int finished;                   /* TRUE once its last bounds are sent */
+        struct Net_node node;           /* state of the node */
+        struct Net_heap events;         /* its pending events */
+        int nin;                        /* channels into the node */
+        struct Spsc_ring **in;          /* the channels */
+        long int *in_clock;             /* latest time received on each */
+        struct Spsc_ring **to;          /* channel to each node, NULL for none */
+        long int *sent;                 /* latest time sent to each node */
+        unsigned long long nulls;       /* null messages sent */
+        long int nheld;                 /* messages waiting for room */
+        long int held_size;             /* room in held */
+        struct Net_held *held;          /* the messages, in the order sent */
+        char *blocked;                  /* scratch for Net_flush, one per node */
+        };
+
+/* thread of the conservative engine - steps nodes first, first +   */
+/* stride ... in turn                                                 */
+struct Net_worker {
+        struct Net_lp *lp;              /* every logical process */
+        pthread_t thread;               /* thread running Net_worker_run */
+        int first;                      /* its first node */
+        int stride;                     /* number of threads */
+        int nnode;                      /* number of nodes */
+        };
+
+/* record of an event the Time Warp engine has handled but not yet */
+/* committed - enough to undo it.  The queue change is implied by   */
+/* the event type, and random numbers are keyed, so need no saving. */
+struct Tw_record {
+        struct Net_event ev;            /* the event */
+        struct Net_state saved;         /* node state before it */
+        struct Net_out out;             /* what it led to */
+        };
+
+/* message between Time Warp threads - a job arriving at a node, or */
+/* an anti-message cancelling one sent earlier                       */
+struct Tw_msg {
+        struct Tw_msg *next;            /* next in the inbox or delivery list */
+        int anti;                       /* TRUE for an anti-message */
+        int color;                      /* parity of the sender's GVT round */
+        struct Net_event ev;            /* the arrival */
+        };
+
+/* logical process of the Time Warp engine - one node */
+struct Tw_lp {
+        struct Net_node node;           /* state of the node */
+        struct Net_heap pending;        /* events not yet handled */
+        int slot;                       /* place in its thread's heap */
+        long int first;                 /* oldest record not yet committed */
+        long int nlog;                  /* records in log */
+        long int size;                  /* room in log */
+        struct Tw_record *log;          /* events handled, in order */
+        };
+
+/* thread of the Time Warp engine - runs a block of logical processes */
+struct Tw_thread {
+        struct Tw_engine *eng;          /* engine it belongs to */
+        pthread_t thread;               /* thread running Tw_run */
+        int lo, hi;                     /* its logical processes */
+        int nsched;                     /* logical processes in sched */
+        int *sched;                     /* the processes, a heap ordered by next event */
+        struct Tw_msg *inbox __attribute__((aligned(64)));     /* from other threads, newest first */
+        struct Tw_msg *head __attribute__((aligned(64)));      /* to deliver, oldest first */
+        struct Tw_msg *tail;
+        struct Tw_msg *spare;           /* delivered messages kept for sending again */
+        unsigned long long sent[2];     /* messages sent to other threads, by color */
+        unsigned long long received[2]; /* messages taken from the inbox, by color */
+        int round;                      /* last GVT round joined */
+        int reported;                   /* last GVT round reported to */
+        long int red_min;               /* earliest message sent since joining it */
+        long int gvt;                   /* GVT last committed to */
+        long int batch;                 /* events handled from its share */
+        int wait;                       /* round whose end brings a new share, 0 for none */
+        unsigned long long handled;     /* events handled */
+        unsigned long long undone;      /* events rolled back */
+        unsigned long long rollbacks;   /* rollbacks */
+        unsigned long long antis;       /* anti-messages sent */
+        };
+
+/* optimistic network engine - the nodes are dealt out in blocks to */
+/* the threads                                                       */
+struct Tw_engine {
+        struct Net_model *net;          /* network, shared read-only */
+        struct Sim_parms *parms;        /* length and seed, shared read-only */
+        int nthread;                    /* threads */
+        struct Tw_thread *th;           /* the threads */
+        struct Tw_lp *lp;               /* the logical processes */
+        int *owner;                     /* thread running each node */
+        pthread_mutex_t gvt_lock;       /* guards the GVT round */
+        int round;                      /* number of the latest GVT round */
+        int phase;                      /* TW_IDLE, TW_JOIN or TW_REPORT */
+        int joined;                     /* threads that have joined it */
+        int reported;                   /* threads that have reported to it */
+        long int round_min;             /* least time reported so far */
+        long int gvt;                   /* global virtual time */
+        int finished;                   /* last GVT round to finish */
+        };
+
+/* processors of each NUMA node that the process may run on */
+struct Numa_topo {
+        int nnode;                      /* nodes with usable processors */
+        int id[NUMA_MAX_NODES];         /* number of each node */
+        int ncpu[NUMA_MAX_NODES];       /* its usable processors */
+        int *cpu[NUMA_MAX_NODES];       /* the processors */
+        };
+
+/* pool of the records one thread's simulations use - contexts,     */
+/* events, queue nodes and customers.  Slabs are mapped by the       */
+/* thread itself, so the first touch puts them on its NUMA node, and */
+/* freed records are kept for reuse rather than handed back.        */
+struct Node_pool {
+        void *free[POOL_KINDS];         /* free records of each kind, linked through */
+                                        /*    their first word */
+        char *slab;                     /* slab records are being cut from */
+        size_t used;                    /* bytes of it used */
+        char *slabs;                    /* every slab, linked through its header */
+        };
+
+/* function declarations */
+void arrive(struct Sim_context *sim, struct event_node *ev_num);
+void depart(struct Sim_context *sim, struct event_node *ev_num);
+void start_service(struct Sim_context *sim);
+void Gen_arrival(struct Sim_context *sim);
+void Gen_departure(struct Sim_context *sim, struct Custs *index);
+void Read_parms(struct Sim_parms *parms);
+void Read_options(struct Sim_parms *parms, int argc, char *argv[]);
+void Process_statistics(struct Sim_context *sim);
+void Initialize(struct Sim_context *sim);
+void Simulate(struct Sim_context *sim);
+void Clear_lists(struct Sim_context *sim);
+void Run_antithetic(struct Sim_parms *parms, long int pairs);
+void Run_replications(struct Sim_parms *parms, long int reps, int threads);
+void *Replication_worker(void *arg);
+struct Sweep *Load_sweep(char *fname);
+void Run_sweep(struct Sim_parms *parms, int threads);
+void *Sweep_worker(void *arg);
+long int Sweep_next(struct Sweep_worker *work);
+void Run_lanes(struct Rep_worker *work, unsigned long int first);
+long int Lane_burst(struct Sim_parms *parms, unsigned long int rep, unsigned long int cust);
+int Lane_push(struct Lane_queue *q, struct Lane_job *job);
+void Lane_pop(struct Lane_queue *q, struct Lane_job *job);
+int Lane_before(struct Lane_job *a, struct Lane_job *b);
+int Pool_size(int threads, long int jobs);
+struct Numa_topo *Numa_topology(void);
+void Numa_free(struct Numa_topo *topo);
+int Place_worker(struct Numa_topo *topo, int policy, int w, int *node);
+int Pin_thread(int cpu);
+struct Node_pool *Npool_create(void);
+void *Npool_get(struct Node_pool *pool, int kind, size_t size);
+void Npool_put(struct Node_pool *pool, int kind, void *rec);
+void Npool_destroy(struct Node_pool *pool);
+void Sweep_point(struct Sweep_worker *work, long int k);
+int Sweep_run_point(struct Sim_parms *base, double *point, long int k,
+                    struct Sweep_result *res, struct Hdr_hist *hist);
+void Sweep_write(FILE *out, struct Sim_parms *parms, double *point, long int k,
+                 struct Sweep_result *res);
+double *Sweep_points(struct Sim_parms *parms, long int *npoint);
+FILE *Sweep_open(struct Sim_parms *parms);
+void Run_shards(struct Sim_parms *parms, int procs);
+pid_t Shard_spawn(struct Shard_region *region, struct Sim_parms *parms, double *point);
+long int Shard_claim(struct Shard_region *region, int me);
+long int Shard_flush(struct Shard_region *region, struct Sim_parms *parms, double *point,
+                     FILE *out, struct Hdr_hist *all_hist, long int next, int final);
+int Shard_pending(struct Shard_region *region);
+struct Net_model *Load_network(char *fname);
+void Net_free(struct Net_model *net);
+void Run_network(struct Sim_parms *parms);
+void Run_network_parallel(struct Sim_parms *parms);
+void *Net_worker_run(void *arg);
+int Net_lp_step(struct Net_lp *lp);
+int Net_flush(struct Net_lp *lp);
+long int Net_drain(struct Net_lp *lp);
+void Net_send(struct Net_lp *lp, int dest, long int time, struct Net_job *job);
+long int Net_bound(struct Net_lp *lp, long int min_in);
+void Net_init_node(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                   int i, struct Net_heap *events);
+void Net_handle(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                struct Net_event *ev, struct Net_out *out);
+void Net_enqueue(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                 struct Net_job *job, long int t, struct Net_out *out);
+void Net_report(struct Sim_parms *parms, struct Net_node *nodes);
+int Net_before(struct Net_event *a, struct Net_event *b);
+void Net_push(struct Net_heap *h, struct Net_event *ev);
+void Net_pop(struct Net_heap *h, struct Net_event *ev);
+void Net_drop_top(struct Net_heap *h);
+void Net_remove(struct Net_heap *h, struct Net_event *ev);
+void Netq_push(struct Net_queue *q, struct Net_job *job);
+void Netq_pop(struct Net_queue *q, struct Net_job *job);
+void Netq_drop_top(struct Net_queue *q);
+void Netq_remove(struct Net_queue *q, unsigned long long id, int hop, long int arrive);
+int Net_same(struct Net_event *a, struct Net_event *b);
+long int Net_cancel_slot(struct Net_cancel *c, struct Net_event *ev);
+void Net_cancel_add(struct Net_cancel *c, struct Net_event *ev);
+int Net_cancel_take(struct Net_cancel *c, struct Net_event *ev);
+void Run_network_timewarp(struct Sim_parms *parms, int threads);
+void *Tw_run(void *arg);
+void Tw_handle(struct Tw_thread *th, struct Tw_lp *lp);
+int Tw_earlier(struct Tw_lp *a, struct Tw_lp *b);
+void Tw_resched(struct Tw_thread *th, struct Tw_lp *lp);
+void Tw_send(struct Tw_thread *th, struct Net_event *ev, int anti);
+void Tw_drain(struct Tw_thread *th);
+void Tw_deliver(struct Tw_thread *th, struct Tw_msg *msg);
+void Tw_rollback(struct Tw_thread *th, struct Tw_lp *lp, struct Net_event *ev);
+long int Tw_gvt(struct Tw_thread *th);
+void Tw_fossil(struct Tw_thread *th, long int gvt);
+int Spsc_push(struct Spsc_ring *ring, struct Net_msg *msg);
+int Spsc_pop(struct Spsc_ring *ring, struct Net_msg *msg);
+struct Var_feed *Feed_start(struct Sim_parms *parms, unsigned long int replication,
+                            int antithetic);
+void *Feed_producer(void *arg);
+void Feed_next(struct Var_feed *feed, struct Variate *var);
+void Feed_stop(struct Var_feed *feed);
+struct Sim_context *Sim_create(struct Sim_parms *parms, unsigned long int replication,
+                               int antithetic);
+struct Sim_context *Sim_create_in(struct Sim_parms *parms, unsigned long int replication,
+                                  int antithetic, struct Node_pool *pool);
+void Sim_run(struct Sim_context *sim);
+void Sim_destroy(struct Sim_context *sim);
+double T_quantile(double p, long int df);
+double Normal_quantile(double p);
+void Insert_event(struct Sim_context *sim, int etype, long int etime, struct Custs *custind);
+struct event_node *Remove_event(struct Sim_context *sim);
+void Puton_queue(struct Queue_struct *pqueue, struct Custs *pcust);
+struct Custs *Takoff_queue(struct Queue_struct *pqueue);
+long int expon(float time, double u);
+double Uniform(struct Sim_context *sim, int stream, unsigned long int cust, int draw);
+unsigned long long Mix64(unsigned long long x);
+double Counter_uniform(unsigned seed, unsigned long int replication, int antithetic,
+                       int stream, unsigned long int cust, int draw);
+struct Emp_dist *Load_dist(char *fname);
+int Build_alias(struct Emp_dist *dist, double *weight);
+void Emp_free(struct Emp_dist *dist);
+long int Emp_sample(struct Sim_context *sim, struct Emp_dist *dist, unsigned long int cust);
+long int Emp_draw(struct Emp_dist *dist, double u, double v);
+int Sort_bins(double *value, double *weight, int n);
+void Stat_init(struct Stat *st);
+void Stat_record(struct Stat *st, double x);
+void Stat_merge(struct Stat *st, struct Stat *other);
+double Stat_mean(struct Stat *st);
+double Stat_var(struct Stat *st);
+double Stat_stddev(struct Stat *st);
+void Hdr_init(struct Hdr_hist *h);
+void Hdr_record(struct Hdr_hist *h, long int value);
+void Hdr_merge(struct Hdr_hist *h, struct Hdr_hist *other);
+double Hdr_percentile(struct Hdr_hist *h, double pct);
+void Print_percentiles(struct Sim_parms *parms, struct Hdr_hist *h, char *what);
+int Parse_percentiles(struct Sim_parms *parms, char *list);
+void P2_init(struct P2_quant *est, double p);
+void P2_record(struct P2_quant *est, double x);
+void P2_merge(struct P2_quant *est, struct P2_quant *other);
+double P2_value(struct P2_quant *est);
+void Td_init(struct T_digest *td);
+void Td_add(struct T_digest *td, double x, double w);
+void Td_compress(struct T_digest *td);
+void Td_merge(struct T_digest *td, struct T_digest *other);
+double Td_quantile(struct T_digest *td, double q);
+int Centroid_cmp(const void *a, const void *b);
+void Print_sketches(struct Sim_parms *parms, struct P2_quant *est, struct T_digest *td);
+void Check_stop(struct Sim_context *sim);
+void Batch_init(struct Batch_means *bm);
+int Batch_record(struct Batch_means *bm, double x);
+double Batch_ci(struct Batch_means *bm, long int skip, double *mean, double *corr);
+long int Warmup_batches(struct Sim_context *sim);
+double Control_variate(long int k, double *y, double *x1, double *x2,
+                       double mu1, double mu2, double *half);
+double Burst_mean_ticks(struct Sim_parms *parms);
+double Ceil_mean(double a, double b);
+double Iat_mean_ticks(struct Sim_parms *parms);
+void Print_control(struct Sim_parms *parms, long int k, double *y, double *x1, double *x2,
+                   double plain_half);
+void Mser_init(struct Mser *ms);
+void Mser_record(struct Mser *ms, double x, long int now);
+long int Mser_truncate(struct Mser *ms, double *mean);
+void Update_time_avg(struct Sim_context *sim, long int now);
+void Record_class(struct Sim_context *sim, long int resp, long int wait, long int burst);
+void Print_classes(struct Sim_context *sim);
+double Analytic_sjf(struct Sim_parms *parms);
+double Sjf_integrand(double u, double rho);
+double Sjf_simpson(double a, double b, double fa, double fm, double fb, double whole,
+                   double tol, int depth, double rho, int *failed);
+void Check_analytic(struct Sim_parms *parms, double sim_mean);
+void Bin_probs(struct Emp_dist *dist, double *p);
+struct Rate_profile *Load_profile(char *fname);
+double Profile_arrival(struct Sim_context *sim, struct Rate_profile *prof, unsigned long int cust);
+struct Mmpp *Load_mmpp(char *fname);
+void Mmpp_free(struct Mmpp *proc);
+double Mmpp_arrival(struct Sim_context *sim, struct Mmpp *proc, unsigned long int cust);
+
+#ifndef SJF_NO_MAIN
+/*********************************************************************/
+/* Name: main                                                   */
+/* Description                                                  */
+/*    This function reads the options and parameters, then either  */
+/* runs a single simulation and prints its statistics, or runs the  */
+/* requested antithetic pairs, replications, sweep or network.      */
+/*********************************************************************/
+int main(int argc, char *argv[])
+  {
+  struct Sim_parms parms;
+  struct Sim_context *sim;
+  memset(&parms, 0, sizeof(struct Sim_parms));
+  Read_options(&parms, argc, argv);
+  Read_parms(&parms);
+  if(parms.analytic_only)
+         {
+         printf(" Analytic results\n");
+         Check_analytic(&parms, -1);
+         return(0);
+         }
+  if(parms.num_pairs > 0)
+         {
+         Run_antithetic(&parms, parms.num_pairs);
+         return(0);
+         }
+  if(parms.num_reps > 0)
+         {
+         Run_replications(&parms, parms.num_reps, parms.num_threads);
+         return(0);
+         }
+  if(parms.network != NULL)
+         {
+         if(parms.net_parallel)
+                Run_network_parallel(&parms);
+         else if(parms.net_timewarp)
+                Run_network_timewarp(&parms, parms.num_threads);
+         else
+                Run_network(&parms);
+         return(0);
+         }
+  if(parms.sweep != NULL)
+         {
+         if(parms.num_procs > 0 || parms.mem_limit > 0)
+                Run_shards(&parms, parms.num_procs);
+         else
+                Run_sweep(&parms, parms.num_threads);
+         return(0);
+         }
+  sim = Sim_create(&parms, 0, FALSE);
+  if(sim == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         return(1);
+         }
+  if(parms.pipeline)
+         {
+         sim->feed = Feed_start(&parms, 0, FALSE);
+         if(sim->feed == NULL)
+                printf(" ***Warning - variate thread not started, drawing them inline***\n");
+         }
+  Sim_run(sim);
+  Feed_stop(sim->feed);
+  sim->feed = NULL;
+  Process_statistics(sim);
+  Sim_destroy(sim);
+  return(0);
+  }
+#endif
+
+/*********************************************************************/
+/* Name: Sim_create                                                  */
+/* Description                                                       */
+/*    This function allocates a simulation context for the given     */
+/* parameters, replication (substream) and antithetic flag, and      */
+/* initializes it.  It returns NULL if memory runs out.  The         */
+/* parameters are only read, so any number of contexts may share     */
+/* them and run at the same time.                                    */
+/*********************************************************************/
+struct Sim_context *Sim_create(struct Sim_parms *parms, unsigned long int replication,
+                               int antithetic)
+  {
+  return(Sim_create_in(parms, replication, antithetic, NULL));
+  }
+
+/*********************************************************************/
+/* Name: Sim_create_in                                               */
+/* Description                                                       */
+/*    This function is Sim_create with the context and all of its    */
+/* records taken from a node pool, NULL for malloc.  A pool belongs  */
+/* to one thread, so only that thread may run the context.           */
+/*********************************************************************/
+struct Sim_context *Sim_create_in(struct Sim_parms *parms, unsigned long int replication,
+                                  int antithetic, struct Node_pool *pool)
+  {
+  struct Sim_context *sim;
+  sim = (struct Sim_context *) Npool_get(pool, POOL_CONTEXT, sizeof(struct Sim_context));
+  if(sim == NULL)
+         return(NULL);
+  sim->pool = pool;
+  sim->feed = NULL;
+  sim->parms = parms;
+  sim->replication = replication;
+  sim->antithetic = antithetic;
+  Initialize(sim);
+  return(sim);
+  }
+
+/*********************************************************************/
+/* Name: Sim_run                                                     */
+/* Description                                                       */
+/*    This procedure runs a context created by Sim_create to the end */
+/* of simulation.  Its statistics are then left in the context.      */
+/*********************************************************************/
+void Sim_run(struct Sim_context *sim)
+  {
+  Simulate(sim);
+  }
+
+/*********************************************************************/
+/* Name: Sim_destroy                                                 */
+/* Description                                                       */
+/*    This procedure frees a context and everything left in it.      */
+/*********************************************************************/
+void Sim_destroy(struct Sim_context *sim)
+  {
+  Clear_lists(sim);
+  Npool_put(sim->pool, POOL_CONTEXT, sim);
+  }
+
+/*********************************************************************/
+/* Name: Feed_start                                                  */
+/* Description                                                       */
+/*    This function starts a thread drawing the interarrival and     */
+/* burst times of a run ahead of it, customer by customer, into a    */
+/* ring read by Feed_next.  The variates are keyed by customer       */
+/* number, so they are the ones the run would have drawn itself.     */
+/* It returns NULL if the thread cannot be started.                  */
+/*********************************************************************/
+struct Var_feed *Feed_start(struct Sim_parms *parms, unsigned long int replication,
+                            int antithetic)
+  {
+  struct Var_feed *feed;
+  feed = (struct Var_feed *) aligned_alloc(64, sizeof(struct Var_feed));
+  if(feed == NULL)
+         return(NULL);
+  feed->parms = parms;
+  feed->replication = replication;
+  feed->antithetic = antithetic;
+  feed->head = feed->tail_seen = 0;
+  feed->tail = feed->head_seen = 0;
+  feed->stop = FALSE;
+  if(pthread_create(&feed->thread, NULL, Feed_producer, feed) != 0)
+         {
+         free(feed);
+         return(NULL);
+         }
+  return(feed);
+  }
+
+/*********************************************************************/
+/* Name: Feed_producer                                               */
+/* Description                                                       */
+/*    This function is the producer thread of a feed.  It draws      */
+/* FEED_BATCH customers' variates at a time into a local batch,      */
+/* waits for room in the ring and publishes the batch with a single  */
+/* store of the tail, until the consumer sets stop.                  */
+/*********************************************************************/
+void *Feed_producer(void *arg)
+  {
+  struct Var_feed *feed;
+  struct Sim_parms *parms;
+  struct Variate batch[FEED_BATCH];
+  unsigned long int cust, tail;
+  double v;
+  int i;
+  feed = (struct Var_feed *) arg;
+  parms = feed->parms;
+  cust = 0;
+  tail = 0;
+  while(!__atomic_load_n(&feed->stop, __ATOMIC_ACQUIRE))
+         {
+         for(i = 0; i < FEED_BATCH; i++, cust++)
+                {
+                batch[i].iarrive = expon(parms->iarrive_time,
+                                         Counter_uniform(parms->seed, feed->replication,
+                                                         feed->antithetic, ARRIVAL_STREAM,
+                                                         cust, 0));
+                if(parms->burst_dist != NULL)
+                       {
+                       v = parms->burst_dist->raw ?
+                           Counter_uniform(parms->seed, feed->replication, feed->antithetic,
+                                           SERVICE_STREAM, cust, 1) : 0;
+                       batch[i].burst = Emp_draw(parms->burst_dist,
+                                                 Counter_uniform(parms->seed, feed->replication,
+                                                                 feed->antithetic,
+                                                                 SERVICE_STREAM, cust, 0), v);
+                       }
+                else
+                       batch[i].burst = expon(parms->service_time,
+                                              Counter_uniform(parms->seed, feed->replication,
+                                                              feed->antithetic,
+                                                              SERVICE_STREAM, cust, 0));
+                }
+         /* the consumer's head is read again only when the ring looks full */
+         while(tail + FEED_BATCH - feed->head_seen > FEED_RING)
+                {
+                feed->head_seen = __atomic_load_n(&feed->head, __ATOMIC_ACQUIRE);
+                if(tail + FEED_BATCH - feed->head_seen <= FEED_RING)
+                       break;
+                if(__atomic_load_n(&feed->stop, __ATOMIC_ACQUIRE))
+                       return(NULL);
+                sched_yield();
+                }
+         for(i = 0; i < FEED_BATCH; i++)
+                feed->buf[(tail + i) & (FEED_RING - 1)] = batch[i];
+         tail += FEED_BATCH;
+         __atomic_store_n(&feed->tail, tail, __ATOMIC_RELEASE);
+         }
+  return(NULL);
+  }
+
+/*********************************************************************/
+/* Name: Feed_next                                                   */
+/* Description                                                       */
+/*    This procedure takes the next customer's variates from a feed, */
+/* waiting for the producer if the ring is empty.  Only the thread   */
+/* running the simulation calls it.                                 */
+/*********************************************************************/
+void Feed_next(struct Var_feed *feed, struct Variate *var)
+  {
+  unsigned long head;
+  head = feed->head;
+  /* the producer's tail is read again only when the ring looks empty */
+  while(head == feed->tail_seen)
+         {
+         feed->tail_seen = __atomic_load_n(&feed->tail, __ATOMIC_ACQUIRE);
+         if(head == feed->tail_seen)
+                sched_yield();
+         }
+  *var = feed->buf[head & (FEED_RING - 1)];
+  __atomic_store_n(&feed->head, head + 1, __ATOMIC_RELEASE);
+  }
+
+/*********************************************************************/
+/* Name: Feed_stop                                                   */
+/* Description                                                       */
+/*    This procedure ends the producer of a feed and frees it.       */
+/*********************************************************************/
+void Feed_stop(struct Var_feed *feed)
+  {
+  if(feed == NULL)
+         return;
+  __atomic_store_n(&feed->stop, TRUE, __ATOMIC_RELEASE);
+  pthread_join(feed->thread, NULL);
+  free(feed);
+  }
+
+/*********************************************************************/
+/* Name: Simulate                                               */
+/* Description                                                  */
+/*    This function performs the main control loop of the simulation.*/
+/* It performs the following steps:                                     */
+/*    1 - schedules an end of simulation.                               */
+/*    2 - generates the first arrival.                          */
+/*    3 - processes the events on the event list until the end of       */
+/*        simulation event i reached.                           */
+/*    4 - frees event node after it has been processed.                 */
+/* The context must have been set up by Initialize.                 */
+/*********************************************************************/
+void Simulate(struct Sim_context *sim)
+  {
+  int not_done;
+  struct event_node *event;
+  /* schedule an end of simulation, the stopping rule may end it sooner */
+  Insert_event(sim, EOS, (sim->parms->seq_target > 0) ?
+               sim->parms->max_length : sim->parms->sim_length, NULL);
+  /* generate first arrival */
+  Gen_arrival(sim);
+  /* main loop to process the event list */
+  not_done = TRUE;
+  while(not_done)
+    {
+    /* get next event */
+    event = Remove_event(sim);
+    /* bring the time-weighted statistics up to the event, then update clock */
+    Update_time_avg(sim, event->ev_time);
+    sim->clock = event->ev_time;
+    /* process event type */
+    switch (event->ev_type)
+        {
+                case ARRIVAL  : arrive(sim, event);
+                              break;
+                case COMPLETE : depart(sim, event);
+                              break;
+                case EOS      : not_done = FALSE;
+                              break;
+                default       : printf("***Error - invalid event type\n");
+                }
+        /* free event node by marking it unused */
+        Npool_put(sim->pool, POOL_EVENT, event);
+        }
+  }
+
+/*********************************************************************/
+/* Name: arrive                                                 */
+/* Description                                                  */
+/*    This function processes an arrival to the system.                 */
+/*     It performs                                              */
+/* the followiong steps:                                                */
+/*    1 - generates the next arrival.                                   */
+/*    2 - sets the system statistics.                                   */
+/*    3 - puts the customer into the queue.                             */
+/*    4 - if the server is not busy then calls start_service.           */
+/**********************************************************************/
+void arrive(struct Sim_context *sim, struct event_node *ev_num)
+  {
+  struct Custs *index;
+  /* generate the next arrival */
+  Gen_arrival(sim);
+  /* set statistics gathering variable */
+  index = ev_num->cust_index;
+  index->arrive_time = sim->clock;
+  index->interarrival = sim->clock - sim->prev_arrival;
+  sim->prev_arrival = sim->clock;
+  sim->num_arrivals++;
+  sim->unfinished += index->CPU_time;
+  /* put the customer n the queue */
+  Puton_queue(&sim->sjf, index);
+  sim->num_in_queue++;
+  /* if server is not busy then an idle period ends, start service */
+  if(!sim->busy)
+         {
+         Stat_record(&sim->idle_stat, sim->clock - sim->period_start);
+         Hdr_record(&sim->idle_hist, sim->clock - sim->period_start);
+         sim->period_start = sim->clock;
+         start_service(sim);
+         }
+  return;
+  }
+
+/**************************************************************/
+/* Name: start_service                                        */
+/* Description                                                */
+/*    This function performs the following steps:             */
+/*    1 - removes the first customer from the queue.          */
+/*    2 - sets the server to busy.                            */
+/*    3 - schedules a departure event.                        */
+/**************************************************************/
+void start_service(struct Sim_context *sim)
+  {
+  struct Custs *index;
+  /* remove the first customer from the queue */
+  index = Takoff_queue(&sim->sjf);
+  sim->num_in_queue--;
+  /* waiting is over, record it and the service time */
+  index->start_time = sim->clock;
+  Stat_record(&sim->wait_stat, sim->clock - index->arrive_time);
+  Hdr_record(&sim->wait_hist, sim->clock - index->arrive_time);
+  Stat_record(&sim->serv_stat, index->CPU_time);
+  /* set server to busy */
+  sim->busy = TRUE;
+  /* schedule a departure event */
+  Gen_departure(sim, index);
+  return;
+  }
+
+/********************************************************************/
+/* Name: depart                                                     */
+/* Description                                                      */
+/*    This function processes a departure from the server event. It */
+/* performs the following steps:                                    */
+/*    1 - sets the server to idle.                                  */
+/*    2 - accumulate response time statistics.                      */
+/*    3 - remove the customer from the system.                      */
+/*    4 - if the queue is not empty, then start service.            */
+/********************************************************************/
+void depart(struct Sim_context *sim, struct event_node *ev_num)
+  {
+  struct Custs *index;
+  long int temp;
+  int i;
+  /* set server to idle */
+  sim->busy = FALSE;
+  /* accumulate response time */
+  index = ev_num->cust_index;
+  temp = sim->clock - index->arrive_time;
+#if DEBUG
+  printf(" Response time for customer is %d\n", temp);
+#endif
+  Stat_record(&sim->resp_stat, temp);
+  Hdr_record(&sim->resp_hist, temp);
+  Batch_record(&sim->burst_batch, index->CPU_time);
+  Batch_record(&sim->iat_batch, index->interarrival);
+  if(Batch_record(&sim->resp_batch, temp) && sim->parms->seq_target > 0 && !sim->stop_scheduled)
+         Check_stop(sim);
+  Mser_record(&sim->resp_mser, temp, sim->clock);
+  Record_class(sim, temp, index->start_time - index->arrive_time, index->CPU_time);
+  for(i = 0; i < sim->parms->num_pct; i++)
+         P2_record(&sim->resp_p2[i], temp);
+  Td_add(&sim->resp_td, temp, 1);
+  /* remove customer from the system */
+  Npool_put(sim->pool, POOL_CUST, index);
+ /* if queue is non-empty, start service */
+  if(sim->sjf.q_head != NULL)
+         start_service(sim);
+  else
+         {
+         /* the server goes idle - a busy period ends */
+         Stat_record(&sim->busy_stat, sim->clock - sim->period_start);
+         Hdr_record(&sim->busy_hist, sim->clock - sim->period_start);
+         sim->period_start = sim->clock;
+         }
+  return;
+  }
+
+/*********************************************************************/
+/* Name: Gen_arrival                                                 */
+/* Description                                                       */
+/*  This function will generate a new arrival. It has one parameter, */
+/* stream, which is the random number generator stream to be used.It */
+/* performs the following steps:                                     */
+/*    1 - gets a new customer.                                       */
+/*    2 - generates an exponential arrival time, or the next arrival */
+/*        of the rate profile or modulated process when one was      */
+/*        given, or takes it from the feed with -G.                  */
+/*    3 - generates the customer's burst time.                       */
+/*    4 - inserts arrival event into the event list.                 */
+/*********************************************************************/
+void Gen_arrival(struct Sim_context *sim)
+  {
+  long int time;
+  struct Custs *index;
+  struct Variate var;
+  /* get new customer */
+  index = (struct Custs *) Npool_get(sim->pool, POOL_CUST, sizeof(struct Custs));
+  index->cust_num = sim->next_cust++;
+  if(sim->feed != NULL)
+         {
+         /* drawn ahead by the producer thread, the burst is kept for arrive */
+         Feed_next(sim->feed, &var);
+         time = var.iarrive;
+         index->CPU_time = var.burst;
+         }
+  else if(sim->parms->rate_profile != NULL)
+         {
+         /* profile arrivals are kept exact and rounded up to a tick */
+         sim->last_arrival = Profile_arrival(sim, sim->parms->rate_profile, index->cust_num);
+         time = (long int) ceil(sim->last_arrival) - sim->clock;
+         }
+  else if(sim->parms->mmpp != NULL)
+         {
+         sim->last_arrival = Mmpp_arrival(sim, sim->parms->mmpp, index->cust_num);
+         time = (long int) ceil(sim->last_arrival) - sim->clock;
+         }
+  else
+         {
+         /* generate exponential interarrival time */
+         time = expon(sim->parms->iarrive_time, Uniform(sim, ARRIVAL_STREAM, index->cust_num, 0));
+         }
+  /* the burst is drawn now, so the control covers every customer */
+  /* generated and not only those SJF has let into service        */
+  if(sim->feed == NULL && sim->parms->burst_dist != NULL)
+         index->CPU_time = Emp_sample(sim, sim->parms->burst_dist, index->cust_num);
+  else if(sim->feed == NULL)
+         index->CPU_time = expon(sim->parms->service_time,
+                                 Uniform(sim, SERVICE_STREAM, index->cust_num, 0));
+  sim->iat_sum += time;
+  sim->burst_sum += index->CPU_time;
+#if DEBUG
+  printf(" Interarrival time for customer is %d\n", time);
+  printf(" Arrival time for customer is %d\n", sim->clock + time);
+#endif
+  /* add the event to the list */
+  Insert_event(sim, ARRIVAL, sim->clock+time, index);
+  return;
+  }
+
+/*********************************************************************/
+/* Name: Gen_departure                                          */
+/* Description                                                  */
+/*   This function generates a departure event from the server. It      */
+/*   has two parameters: 1) stream - random number generator stream, */
+/*   and 2) index - index of customer departing. The following  */
+/*   steps are performed:                                            */
+/*    1 - generate the service time.                                 */
+/*    2 - insert the departure event into the event list.            */
+/*********************************************************************/
+void Gen_departure(struct Sim_context *sim, struct Custs *index)
+  {
+  long int time;
+  /* generate exponential service time */
+  time = index->CPU_time; // CHANGED BY ME
+#if DEBUG
+  printf(" Service time for customer is %d\n", time);
+  printf(" Departure time for customer is %d\n", sim->clock + time);
+#endif
+  /* add departure event to the event list */
+  Insert_event(sim, COMPLETE, time+sim->clock, index);
+  return;
+  }
+
+/**************************************************************/
+/* Name: Read_parms                                           */
+/* Description                                                */
+/*    This function inputs the required simulation parameters,*/
+/* unless they were given on the command line.                */
+/**************************************************************/
+void Read_parms(struct Sim_parms *parms)
+  {
+  printf("   SIMULATION -- M/M/1 Queueing System\n");
+  if(!parms->parms_given)
+         {
+         printf("      Input the following parameters:\n");
+         printf("      mean interarrival time => ");
+         scanf("%e", &parms->iarrive_time);
+         printf("      mean service time => ");
+         scanf("%e", &parms->service_time);
+         printf("      length of simulation => ");
+         scanf("%ld", &parms->sim_length);
+         printf("      seed for the random number generator => ");
+         scanf("%u", &parms->seed);
+         }
+  if(parms->max_length <= 0)
+         parms->max_length = 100 * parms->sim_length;
+  if(parms->burst_dist != NULL)
+         printf(" Service times from empirical distribution, mean %.3f\n",
+                parms->burst_dist->mean);
+  if(parms->rate_profile != NULL)
+         printf(" Arrivals from %s rate profile, mean interarrival %.3f\n",
+                parms->rate_profile->linear ? "piecewise linear" : "piecewise constant",
+                1 / (100 * parms->rate_profile->mean_rate));
+  if(parms->mmpp != NULL)
+         printf(" Arrivals from %d phase MMPP, mean interarrival %.3f\n",
+                parms->mmpp->nphase, 1 / (100 * parms->mmpp->mean_rate));
+  if(parms->seq_target > 0)
+         printf(" Runs end when the CI half-width is within %g of the mean,"
+                " at most %ld units\n", parms->seq_target, parms->max_length);
+  else
+         printf(" Simulation time = %ld units\n", parms->sim_length);
+  printf(" Simulation begins...\n");
+  }
+
+/*********************************************************************/
+/* Name: Read_options                                                */
+/* Description                                                       */
+/*    This function processes the command line options.  Options     */
+/* that are not given keep the behaviour of the original model.      */
+/*********************************************************************/
+void Read_options(struct Sim_parms *parms, int argc, char *argv[])
+  {
+  int opt;
+  Parse_percentiles(parms, "50,90,99,99.9");
+  parms->check_tol = 0.05;
+  while((opt = getopt(argc, argv, "b:a:r:m:p:e:x:AV:n:t:S:o:LK:M:N:PWY:G")) != -1)
+        {
+        switch (opt)
+                {
+                case 'b' : parms->burst_dist = Load_dist(optarg);
+                           if(parms->burst_dist == NULL)
+                                exit(1);
+                           break;
+                case 'a' : parms->num_pairs = atol(optarg);
+                           break;
+                case 'r' : parms->rate_profile = Load_profile(optarg);
+                           if(parms->rate_profile == NULL)
+                                exit(1);
+                           break;
+                case 'm' : parms->mmpp = Load_mmpp(optarg);
+                           if(parms->mmpp == NULL)
+                                exit(1);
+                           break;
+                case 'p' : if(!Parse_percentiles(parms, optarg))
+                                exit(1);
+                           break;
+                case 'e' : parms->seq_target = atof(optarg);
+                           break;
+                case 'x' : parms->max_length = atol(optarg);
+                           break;
+                case 'A' : parms->analytic_only = TRUE;
+                           break;
+                case 'V' : parms->check_tol = atof(optarg);
+                           break;
+                case 'n' : parms->num_reps = atol(optarg);
+                           break;
+                case 't' : parms->num_threads = atoi(optarg);
+                           break;
+                case 'S' : parms->sweep = Load_sweep(optarg);
+                           if(parms->sweep == NULL)
+                                exit(1);
+                           break;
+                case 'o' : parms->sweep_out = optarg;
+                           break;
+                case 'L' : parms->lockstep = TRUE;
+                           break;
+                case 'K' : parms->num_procs = atoi(optarg);
+                           break;
+                case 'M' : parms->mem_limit = atol(optarg);
+                           break;
+                case 'N' : parms->network = Load_network(optarg);
+                           if(parms->network == NULL)
+                                exit(1);
+                           break;
+                case 'P' : parms->net_parallel = TRUE;
+                           break;
+                case 'W' : parms->net_timewarp = TRUE;
+                           break;
+                case 'Y' : if(strcmp(optarg, "compact") == 0)
+                                parms->placement = PLACE_COMPACT;
+                           else if(strcmp(optarg, "spread") == 0)
+                                parms->placement = PLACE_SPREAD;
+                           else
+                                {
+                                fprintf(stderr, "%s: -Y takes compact or spread\n", argv[0]);
+                                exit(1);
+                                }
+                           break;
+                case 'G' : parms->pipeline = TRUE;
+                           break;
+                default  : fprintf(stderr, "usage: %s [-b burst_file] [-a pairs] [-r rate_file]"
+                                   " [-m mmpp_file] [-p pct,...] [-e rel_width]"
+                                   " [-x max_length] [-A] [-V tolerance] [-n reps]"
+                                   " [-t threads] [-S sweep_file] [-o out_file] [-L]"
+                                   " [-K procs] [-M megabytes] [-N network_file] [-P] [-W]"
+                                   " [-Y compact|spread] [-G]"
+                                   " [iarrive service length seed]\n", argv[0]);
+                           exit(1);
+                }
+        }
+  /* the model parameters may follow the options instead of being typed in */
+  if(argc - optind == 4)
+        {
+        parms->iarrive_time = atof(argv[optind]);
+        parms->service_time = atof(argv[optind + 1]);
+        parms->sim_length = atol(argv[optind + 2]);
+        parms->seed = strtoul(argv[optind + 3], NULL, 10);
+        parms->parms_given = TRUE;
+        }
+  else if(argc != optind)
+        {
+        fprintf(stderr, "%s: give all four of iarrive service length seed\n", argv[0]);
+        exit(1);
+        }
+  if((parms->num_reps > 0) + (parms->num_pairs > 0) + (parms->sweep != NULL) +
+     (parms->network != NULL) > 1)
+        {
+        fprintf(stderr, "%s: only one of -n, -a, -S and -N can be used\n", argv[0]);
+        exit(1);
+        }
+  if(parms->net_parallel && parms->network == NULL)
+        {
+        fprintf(stderr, "%s: -P needs -N\n", argv[0]);
+        exit(1);
+        }
+  if(parms->net_timewarp && (parms->network == NULL || parms->net_parallel))
+        {
+        fprintf(stderr, "%s: -W needs -N and cannot be used with -P\n", argv[0]);
+        exit(1);
+        }
+  if(parms->placement != PLACE_NONE && parms->num_reps == 0)
+        {
+        fprintf(stderr, "%s: -Y needs -n\n", argv[0]);
+        exit(1);
+        }
+  /* -G pipelines one run, and profile and modulated arrivals depend */
+  /* on the run's own state                                           */
+  if(parms->pipeline && (parms->num_reps > 0 || parms->num_pairs > 0 ||
+                         parms->sweep != NULL || parms->network != NULL ||
+                         parms->rate_profile != NULL || parms->mmpp != NULL))
+        {
+        fprintf(stderr, "%s: -G is for a single run and cannot be used with"
+                " -n, -a, -S, -N, -r or -m\n", argv[0]);
+        exit(1);
+        }
+  if((parms->num_procs > 0 || parms->mem_limit > 0) && parms->sweep == NULL)
+        {
+        fprintf(stderr, "%s: -K and -M need -S\n", argv[0]);
+        exit(1);
+        }
+  /* the lanes implement the plain model only */
+  if(parms->lockstep && (parms->num_reps <= 0 || parms->rate_profile != NULL ||
+                         parms->mmpp != NULL || parms->seq_target > 0))
+        {
+        fprintf(stderr, "%s: -L needs -n and cannot be used with -r, -m or -e\n", argv[0]);
+        exit(1);
+        }
+  if(parms->rate_profile != NULL && parms->mmpp != NULL)
+        {
+        fprintf(stderr, "%s: -r and -m cannot be used together\n", argv[0]);
+        exit(1);
+        }
+  }
+
+/*********************************************************************/
+/* Name: Process_statistics                                     */
+/* Description                                                  */
+/*  This function computes and prints the mean response time for the */
+/*  customers in an M/M/1 system.                               */
+/*********************************************************************/
+void Process_statistics(struct Sim_context *sim)
+  {
+  double mean_resp_time, mean, half, corr;
+  long int d, skip;
+  /* compute mean response time */
+  mean_resp_time = Stat_mean(&sim->resp_stat) / 100.0;
+  /* print out results */
+  printf("...Simulation ends\n");
+  printf(" Simulation results\n");
+  printf(" mean response time ---------> %-6.3f\n", mean_resp_time);
+  printf(" std dev of response time ---> %-6.3f\n", Stat_stddev(&sim->resp_stat) / 100.0);
+  printf(" min / max response time ----> %-6.3f / %-6.3f\n",
+         sim->resp_stat.min / 100.0, sim->resp_stat.max / 100.0);
+  printf(" customers served -----------> %llu\n", sim->resp_stat.count);
+  Check_analytic(sim->parms, mean_resp_time);
+  /* batches in the MSER warm-up are left out of the CI */
+  skip = Warmup_batches(sim);
+  half = Batch_ci(&sim->resp_batch, skip, &mean, &corr);
+  if(sim->resp_batch.nbatch - skip >= 2)
+         {
+         printf(" 95%% CI (batch means) -------> %-6.3f +/- %-6.3f\n", mean / 100.0,
+                half / 100.0);
+         printf(" batches / size / lag 1 corr -> %ld / %ld / %.3f (%ld warm-up dropped)\n",
+                sim->resp_batch.nbatch - skip, sim->resp_batch.size, corr, skip);
+         Print_control(sim->parms, sim->resp_batch.nbatch - skip, sim->resp_batch.mean + skip,
+                       sim->burst_batch.mean + skip, sim->iat_batch.mean + skip, half);
+         }
+  if(sim->parms->seq_target > 0)
+         printf(" run ended at time ----------> %ld (%s)\n", sim->clock,
+                sim->stop_scheduled ? "CI target met" : "CI target not met");
+  /* time averages and Little's law, L = lambda W */
+  if(sim->clock > 0)
+         {
+         printf(" mean number in queue -------> %-6.3f\n", sim->tavg.queue / sim->clock);
+         printf(" mean number in system ------> %-6.3f\n", sim->tavg.system / sim->clock);
+         printf(" server utilization ---------> %-6.3f\n", sim->tavg.busy / sim->clock);
+         printf(" mean unfinished work -------> %-6.3f\n", sim->tavg.work / sim->clock / 100.0);
+         printf(" Little's law L / lambda W --> %-6.3f / %-6.3f\n", sim->tavg.system / sim->clock,
+                (double) sim->num_arrivals / sim->clock * Stat_mean(&sim->resp_stat));
+         }
+  /* steady state estimate with the warm-up removed */
+  d = Mser_truncate(&sim->resp_mser, &mean);
+  if(sim->resp_mser.nbatch > 0)
+         {
+         printf(" MSER-5 mean response time --> %-6.3f\n", mean / 100.0);
+         printf(" warm-up deleted (custs/time) > %ld / %ld%s\n", d * sim->resp_mser.size,
+                d > 0 ? sim->resp_mser.end_time[d-1] : 0,
+                d >= sim->resp_mser.nbatch / 2 ? " - run may be too short" : "");
+         }
+  Print_percentiles(sim->parms, &sim->resp_hist, "response time");
+  Print_sketches(sim->parms, sim->resp_p2, &sim->resp_td);
+  /* queueing delay and burst length separately */
+  printf(" mean waiting time ----------> %-6.3f\n", Stat_mean(&sim->wait_stat) / 100.0);
+  Print_percentiles(sim->parms, &sim->wait_hist, "waiting time");
+  printf(" mean service time ----------> %-6.3f\n", Stat_mean(&sim->serv_stat) / 100.0);
+  printf(" busy periods / mean length -> %llu / %-6.3f\n", sim->busy_stat.count,
+         Stat_mean(&sim->busy_stat) / 100.0);
+  Print_percentiles(sim->parms, &sim->busy_hist, "busy period");
+  printf(" idle periods / mean length -> %llu / %-6.3f\n", sim->idle_stat.count,
+         Stat_mean(&sim->idle_stat) / 100.0);
+  Print_percentiles(sim->parms, &sim->idle_hist, "idle period");
+  Print_classes(sim);
+  }
+
+/*********************************************************************/
+/* Name: Initialize                                             */
+/* Description                                                  */
+/*   This function initializes the event list, queue, customer list, */
+/*   and state variables of a context.                               */
+/*********************************************************************/
+void Initialize(struct Sim_context *sim)
+  {
+  int i;
+  /* initialize the event list */
+  sim->top_event = NULL;
+  sim->last_event = NULL;
+  /* initialize the queue */
+  sim->sjf.q_head = NULL;
+  sim->sjf.q_last = NULL;
+  sim->sjf.pool = sim->pool;
+  /* initialize the state variables */
+  sim->clock = 0;
+  sim->busy = FALSE;
+  sim->next_cust = 0;
+  sim->last_arrival = 0;
+  sim->prof_seg = 0;
+  sim->prof_base = 0;
+  sim->mmpp_phase = 0;
+  Stat_init(&sim->resp_stat);
+  Batch_init(&sim->resp_batch);
+  Batch_init(&sim->burst_batch);
+  Batch_init(&sim->iat_batch);
+  sim->prev_arrival = 0;
+  sim->iat_sum = 0;
+  sim->burst_sum = 0;
+  sim->stop_scheduled = FALSE;
+  Mser_init(&sim->resp_mser);
+  memset(&sim->tavg, 0, sizeof(struct Time_avg));
+  Stat_init(&sim->wait_stat);
+  Stat_init(&sim->serv_stat);
+  Hdr_init(&sim->wait_hist);
+  Stat_init(&sim->busy_stat);
+  Stat_init(&sim->idle_stat);
+  Hdr_init(&sim->busy_hist);
+  Hdr_init(&sim->idle_hist);
+  sim->period_start = 0;
+  for(i = 0; i < NUM_CLASSES; i++)
+         {
+         Stat_init(&sim->size_class[i].resp);
+         Stat_init(&sim->size_class[i].wait);
+         Stat_init(&sim->size_class[i].slowdown);
+         P2_init(&sim->size_class[i].tail, CLASS_PCT);
+         }
+  sim->num_in_queue = 0;
+  sim->unfinished = 0;
+  sim->num_arrivals = 0;
+  Hdr_init(&sim->resp_hist);
+  for(i = 0; i < sim->parms->num_pct; i++)
+         P2_init(&sim->resp_p2[i], sim->parms->pct_list[i] / 100);
+  Td_init(&sim->resp_td);
+  }
+
+/*********************************************************************/
+/* Name: Clear_lists                                                 */
+/* Description                                                       */
+/*   This procedure frees the events, queue nodes and customers left */
+/*   in the system at the end of a simulation, so that another       */
+/*   replication can be started from Initialize.                     */
+/*********************************************************************/
+void Clear_lists(struct Sim_context *sim)
+  {
+  struct event_node *event;
+  /* every customer still in the system is owned by an event or the queue */
+  while(sim->top_event != NULL)
+         {
+         event = Remove_event(sim);
+         if(event->cust_index != NULL)
+                Npool_put(sim->pool, POOL_CUST, event->cust_index);
+         Npool_put(sim->pool, POOL_EVENT, event);
+         }
+  while(sim->sjf.q_head != NULL)
+         Npool_put(sim->pool, POOL_CUST, Takoff_queue(&sim->sjf));
+  }
+
+/*********************************************************************/
+/* Name: Run_antithetic                                              */
+/* Description                                                       */
+/*    This procedure runs the given number of antithetic replication */
+/* pairs.  Both runs of pair p use substream p, the second with 1-U  */
+/* in place of U, and the average of the pair is one observation of  */
+/* the mean response time.  It prints the mean, a 95% confidence     */
+/* interval, and the variance reduction against independent runs.    */
+/*********************************************************************/
+void Run_antithetic(struct Sim_parms *parms, long int pairs)
+  {
+  long int p;
+  int run, i;
+  double resp[2], burst[2], iat[2], var, half, *y, *x1, *x2;
+  struct Stat obs, runs;
+  struct Sim_context *sim;
+  struct Hdr_hist *all_hist;
+  struct P2_quant all_p2[MAX_PCT];
+  struct T_digest *all_td;
+  /* the merged histogram and digest are too big for the stack */
+  all_hist = (struct Hdr_hist *) malloc(sizeof(struct Hdr_hist));
+  all_td = (struct T_digest *) malloc(sizeof(struct T_digest));
+  y = (double *) malloc(pairs * sizeof(double));
+  x1 = (double *) malloc(pairs * sizeof(double));
+  x2 = (double *) malloc(pairs * sizeof(double));
+  if(all_hist == NULL || all_td == NULL || y == NULL || x1 == NULL || x2 == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  Stat_init(&obs);
+  Stat_init(&runs);
+  Hdr_init(all_hist);
+  for(run = 0; run < parms->num_pct; run++)
+         P2_init(&all_p2[run], parms->pct_list[run] / 100);
+  Td_init(all_td);
+  printf(" Running %ld antithetic replication pairs\n", pairs);
+  for(p = 0; p < pairs; p++)
+         {
+         for(run = 0; run < 2; run++)
+                {
+                sim = Sim_create(parms, p, run);
+                if(sim == NULL)
+                       {
+                       printf(" ***Error - out of memory***\n");
+                       exit(1);
+                       }
+                Sim_run(sim);
+                resp[run] = Stat_mean(&sim->resp_stat);
+                burst[run] = sim->next_cust > 0 ? sim->burst_sum / sim->next_cust : 0;
+                iat[run] = sim->next_cust > 0 ? sim->iat_sum / sim->next_cust : 0;
+                Hdr_merge(all_hist, &sim->resp_hist);
+                Td_merge(all_td, &sim->resp_td);
+                for(i = 0; i < parms->num_pct; i++)
+                       P2_merge(&all_p2[i], &sim->resp_p2[i]);
+                Sim_destroy(sim);
+                Stat_record(&runs, resp[run] / 100.0);
+                }
+         Stat_record(&obs, (resp[0] + resp[1]) / 200.0);
+         y[p] = (resp[0] + resp[1]) / 2;
+         x1[p] = (burst[0] + burst[1]) / 2;
+         x2[p] = (iat[0] + iat[1]) / 2;
+         }
+  printf("...Simulation ends\n");
+  printf(" Simulation results\n");
+  printf(" mean response time ---------> %-6.3f\n", Stat_mean(&obs));
+  Check_analytic(parms, Stat_mean(&obs));
+  Print_percentiles(parms, all_hist, "response time");
+  Print_sketches(parms, all_p2, all_td);
+  if(pairs >= 2)
+         {
+         var = Stat_var(&obs);
+         half = T_quantile(0.975, pairs - 1) * sqrt(var / pairs);
+         printf(" 95%% confidence interval ----> %-6.3f +/- %-6.3f\n", Stat_mean(&obs),
+                half);
+         /* an independent pair would have half the variance of one run */
+         if(var > 0)
+                printf(" variance reduction factor --> %-6.3f\n",
+                       Stat_var(&runs) / 2 / var);
+         Print_control(parms, pairs, y, x1, x2, half * 100);
+         }
+  free(y);
+  free(x1);
+  free(x2);
+  free(all_hist);
+  free(all_td);
+  }
+
+/*********************************************************************/
+/* Name: Run_replications                                            */
+/* Description                                                       */
+/*    This procedure runs the given number of independent            */
+/* replications on a pool of threads, one per processor if threads   */
+/* is 0.  Replication r uses substream r whichever thread runs it,   */
+/* and each thread has its own contexts and accumulators, so nothing */
+/* is shared while the runs proceed.  The results do not depend on   */
+/* the number of threads: the means are kept per replication and     */
+/* summed in replication order, histogram counts add up the same in  */
+/* any order, and the sketches, whose merges do not, are built per   */
+/* block of replications and merged in block order.  Then the mean,  */
+/* a 95% confidence interval and the usual percentiles are printed.  */
+/* With -L each thread runs LANE_COUNT replications at a time in     */
+/* lockstep.  With -Y each thread is pinned to a processor by the    */
+/* placement policy and takes its contexts and records from a pool   */
+/* on its own NUMA node, and the throughput of each node is shown.   */
+/*********************************************************************/
+void Run_replications(struct Sim_parms *parms, long int reps, int threads)
+  {
+  long int r, b, nblock;
+  int w, i;
+  double *resp, *burst, *iat, half, elapsed;
+  struct Stat obs;
+  struct Rep_worker *work;
+  struct Rep_block *block;
+  struct Hdr_hist *all_hist;
+  struct P2_quant all_p2[MAX_PCT];
+  struct T_digest *all_td;
+  struct Numa_topo *topo;
+  struct timespec start, end;
+  long int node_reps;
+  int n, node_threads;
+  nblock = (reps < REP_BLOCKS) ? reps : REP_BLOCKS;
+  threads = Pool_size(threads, parms->lockstep ? (reps + LANE_COUNT - 1) / LANE_COUNT : nblock);
+  resp = (double *) malloc(reps * sizeof(double));
+  burst = (double *) malloc(reps * sizeof(double));
+  iat = (double *) malloc(reps * sizeof(double));
+  work = (struct Rep_worker *) malloc(threads * sizeof(struct Rep_worker));
+  block = (struct Rep_block *) malloc(nblock * sizeof(struct Rep_block));
+  all_hist = (struct Hdr_hist *) malloc(sizeof(struct Hdr_hist));
+  all_td = (struct T_digest *) malloc(sizeof(struct T_digest));
+  if(resp == NULL || burst == NULL || iat == NULL || work == NULL || block == NULL ||
+     all_hist == NULL || all_td == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  printf(" Running %ld independent replications on %d threads%s\n", reps, threads,
+         parms->lockstep ? " in lockstep lanes" : "");
+  topo = NULL;
+  if(parms->placement != PLACE_NONE)
+         {
+         topo = Numa_topology();
+         if(topo == NULL)
+                printf(" ***Warning - no memory for the NUMA layout, threads not pinned***\n");
+         else
+                printf(" Pinning threads %s over %d NUMA node%s\n",
+                       parms->placement == PLACE_SPREAD ? "spread" : "compact", topo->nnode,
+                       topo->nnode > 1 ? "s" : "");
+         }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(w = 0; w < threads; w++)
+         {
+         work[w].cpu = -1;
+         work[w].node = 0;
+         if(topo != NULL)
+                work[w].cpu = Place_worker(topo, parms->placement, w, &work[w].node);
+         work[w].parms = parms;
+         work[w].index = w;
+         work[w].stride = threads;
+         work[w].reps = reps;
+         work[w].resp = resp;
+         work[w].burst = burst;
+         work[w].iat = iat;
+         work[w].nblock = nblock;
+         work[w].block = block;
+         if(pthread_create(&work[w].thread, NULL, Replication_worker, &work[w]) != 0)
+                {
+                printf(" ***Error - cannot start replication thread %d***\n", w);
+                exit(1);
+                }
+         }
+  Stat_init(&obs);
+  Hdr_init(all_hist);
+  for(i = 0; i < parms->num_pct; i++)
+         P2_init(&all_p2[i], parms->pct_list[i] / 100);
+  Td_init(all_td);
+  for(w = 0; w < threads; w++)
+         {
+         pthread_join(work[w].thread, NULL);
+         if(work[w].failed)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         Hdr_merge(all_hist, &work[w].hist);
+         }
+  for(b = 0; !parms->lockstep && b < nblock; b++)
+         {
+         Td_merge(all_td, &block[b].td);
+         for(i = 0; i < parms->num_pct; i++)
+                P2_merge(&all_p2[i], &block[b].p2[i]);
+         }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  for(r = 0; r < reps; r++)
+         Stat_record(&obs, resp[r] / 100.0);
+  printf("...Simulation ends\n");
+  printf(" Simulation results\n");
+  printf(" mean response time ---------> %-6.3f\n", Stat_mean(&obs));
+  Check_analytic(parms, Stat_mean(&obs));
+  Print_percentiles(parms, all_hist, "response time");
+  /* the lanes keep only the histogram */
+  if(!parms->lockstep)
+         Print_sketches(parms, all_p2, all_td);
+  if(reps >= 2)
+         {
+         half = T_quantile(0.975, reps - 1) * Stat_stddev(&obs) / sqrt(reps);
+         printf(" 95%% confidence interval ----> %-6.3f +/- %-6.3f\n", Stat_mean(&obs),
+                half);
+         Print_control(parms, reps, resp, burst, iat, half * 100);
+         }
+  printf(" wall time / replications/s -> %.3f / %.1f\n", elapsed,
+         elapsed > 0 ? reps / elapsed : 0);
+  for(n = 0; topo != NULL && n < topo->nnode; n++)
+         {
+         node_threads = 0;
+         node_reps = 0;
+         for(w = 0; w < threads; w++)
+                if(work[w].node == n)
+                       {
+                       node_threads++;
+                       node_reps += work[w].done;
+                       }
+         printf(" NUMA node %d: %d threads, %ld replications, %.1f replications/s\n",
+                topo->id[n], node_threads, node_reps, elapsed > 0 ? node_reps / elapsed : 0);
+         }
+  Numa_free(topo);
+  free(resp);
+  free(burst);
+  free(iat);
+  free(work);
+  free(block);
+  free(all_hist);
+  free(all_td);
+  }
+
+/*********************************************************************/
+/* Name: Replication_worker                                          */
+/* Description                                                       */
+/*    This function is the body of one replication thread.  It runs  */
+/* every stride-th block of replications starting at its index, each */
+/* replication in a fresh context, folding the histogram into its    */
+/* own accumulator and the sketches into the block's.  A pinned      */
+/* thread pins itself before touching any memory, then runs its      */
+/* contexts in a pool of its own so they stay on its NUMA node.      */
+/*********************************************************************/
+void *Replication_worker(void *arg)
+  {
+  struct Rep_worker *work = (struct Rep_worker *) arg;
+  struct Rep_block *blk;
+  struct Sim_context *sim;
+  struct Node_pool *pool;
+  long int r, b;
+  int i;
+  pool = NULL;
+  if(work->cpu >= 0)
+         {
+         if(!Pin_thread(work->cpu))
+                printf(" ***Warning - cannot pin a thread to processor %d***\n", work->cpu);
+         /* lanes keep their own heaps, first touched on this processor */
+         if(!work->parms->lockstep && (pool = Npool_create()) == NULL)
+                printf(" ***Warning - no node pool for processor %d, using malloc***\n",
+                       work->cpu);
+         }
+  work->failed = FALSE;
+  work->done = 0;
+  Hdr_init(&work->hist);
+  if(work->parms->lockstep)
+         {
+         /* lane groups are dealt out the way single replications are */
+         for(r = work->index; r * LANE_COUNT < work->reps && !work->failed; r += work->stride)
+                {
+                Run_lanes(work, r * LANE_COUNT);
+                work->done += (work->reps - r * LANE_COUNT < LANE_COUNT) ?
+                              work->reps - r * LANE_COUNT : LANE_COUNT;
+                }
+         Npool_destroy(pool);
+         return(NULL);
+         }
+  for(b = work->index; b < work->nblock; b += work->stride)
+         {
+         blk = &work->block[b];
+         for(i = 0; i < work->parms->num_pct; i++)
+                P2_init(&blk->p2[i], work->parms->pct_list[i] / 100);
+         Td_init(&blk->td);
+         for(r = b * work->reps / work->nblock; r < (b + 1) * work->reps / work->nblock; r++)
+                {
+                sim = Sim_create_in(work->parms, r, FALSE, pool);
+                if(sim == NULL)
+                       {
+                       work->failed = TRUE;
+                       Npool_destroy(pool);
+                       return(NULL);
+                       }
+                Sim_run(sim);
+                work->done++;
+                work->resp[r] = Stat_mean(&sim->resp_stat);
+                work->burst[r] = sim->next_cust > 0 ? sim->burst_sum / sim->next_cust : 0;
+                work->iat[r] = sim->next_cust > 0 ? sim->iat_sum / sim->next_cust : 0;
+                Hdr_merge(&work->hist, &sim->resp_hist);
+                Td_merge(&blk->td, &sim->resp_td);
+                for(i = 0; i < work->parms->num_pct; i++)
+                       P2_merge(&blk->p2[i], &sim->resp_p2[i]);
+                Sim_destroy(sim);
+                }
+         }
+  Npool_destroy(pool);
+  return(NULL);
+  }
+
+/*********************************************************************/
+/* Name: Run_lanes                                                   */
+/* Description                                                       */
+/*    This procedure runs replications first to first+LANE_COUNT-1   */
+/* in lockstep, one per lane.  Each step every live lane processes   */
+/* its own next event: a loop over the lanes picks each lane's event */
+/* with the active and dep masks, then the event is handled lane by  */
+/* lane, drawing uniforms only for lanes that have an arrival.  The  */
+/* lanes are scalar code run side by side; nothing is vectorized.    */
+/* Only the response, burst and interarrival times -n reports are    */
+/* kept, in flat per-lane heaps.  Events are ordered as the event    */
+/* list orders them, by time and then by when they were scheduled,   */
+/* and the uniforms come from the same keyed streams, so every lane  */
+/* gives exactly the result of the replication run on its own.  Only */
+/* the plain model is handled.                                       */
+/*********************************************************************/
+void Run_lanes(struct Rep_worker *work, unsigned long int first)
+  {
+  struct Sim_parms *parms = work->parms;
+  struct Lanes *ln;
+  struct Lane_queue *q;
+  struct Lane_job job;
+  long int end, t;
+  int l, live;
+  ln = (struct Lanes *) calloc(1, sizeof(struct Lanes));
+  if(ln == NULL)
+         {
+         work->failed = TRUE;
+         return;
+         }
+  end = parms->sim_length;
+  live = 0;
+  for(l = 0; l < LANE_COUNT; l++)
+         {
+         ln->rep[l] = first + l;
+         ln->active[l] = (ln->rep[l] < (unsigned long int) work->reps);
+         live += ln->active[l];
+         /* EOS is scheduled first, then the arrival of customer 0 */
+         ln->seq[l] = 1;
+         ln->arr_cust[l] = 0;
+         ln->next_arr[l] = expon(parms->iarrive_time, Counter_uniform(parms->seed,
+                                 ln->rep[l], FALSE, ARRIVAL_STREAM, 0, 0));
+         ln->next_cpu[l] = Lane_burst(parms, ln->rep[l], 0);
+         ln->iat_sum[l] = ln->next_arr[l];
+         ln->burst_sum[l] = ln->next_cpu[l];
+         ln->arr_seq[l] = ln->seq[l]++;
+         ln->next_dep[l] = MAXLONG;
+         }
+  while(live > 0)
+         {
+         /* next event of each lane - EOS goes ahead of anything else at end */
+         for(l = 0; l < LANE_COUNT; l++)
+                {
+                ln->dep[l] = ln->next_dep[l] < ln->next_arr[l] ||
+                             (ln->next_dep[l] == ln->next_arr[l] &&
+                              ln->dep_seq[l] < ln->arr_seq[l]);
+                t = ln->dep[l] ? ln->next_dep[l] : ln->next_arr[l];
+                ln->active[l] = ln->active[l] && t < end;
+                ln->clock[l] = ln->active[l] ? t : ln->clock[l];
+                }
+         live = 0;
+         for(l = 0; l < LANE_COUNT; l++)
+                {
+                if(!ln->active[l])
+                       continue;
+                live++;
+                q = &ln->queue[l];
+                t = ln->clock[l];
+                if(ln->dep[l])
+                       {
+                       /* departure - record the response time */
+                       ln->resp_count[l]++;
+                       ln->resp_sum[l] += t - ln->serv_arrive[l];
+                       Hdr_record(&work->hist, t - ln->serv_arrive[l]);
+                       ln->next_dep[l] = MAXLONG;
+                       }
+                else
+                       {
+                       /* arrival - queue this customer, then schedule the next one */
+                       job.burst = ln->next_cpu[l];
+                       job.cust = ln->arr_cust[l];
+                       job.arrive = t;
+                       if(!Lane_push(q, &job))
+                              {
+                              work->failed = TRUE;
+                              break;
+                              }
+                       ln->arr_cust[l]++;
+                       ln->next_arr[l] = t + expon(parms->iarrive_time,
+                                                   Counter_uniform(parms->seed, ln->rep[l], FALSE,
+                                                                   ARRIVAL_STREAM,
+                                                                   ln->arr_cust[l], 0));
+                       ln->next_cpu[l] = Lane_burst(parms, ln->rep[l], ln->arr_cust[l]);
+                       ln->iat_sum[l] += ln->next_arr[l] - t;
+                       ln->burst_sum[l] += ln->next_cpu[l];
+                       ln->arr_seq[l] = ln->seq[l]++;
+                       }
+                /* start service if the server is free */
+                if(ln->next_dep[l] == MAXLONG && q->n > 0)
+                       {
+                       Lane_pop(q, &job);
+                       ln->serv_arrive[l] = job.arrive;
+                       ln->next_dep[l] = t + job.burst;
+                       ln->dep_seq[l] = ln->seq[l]++;
+                       }
+                }
+         if(work->failed)
+                break;
+         }
+  for(l = 0; l < LANE_COUNT && ln->rep[l] < (unsigned long int) work->reps; l++)
+         {
+         work->resp[ln->rep[l]] = ln->resp_count[l] > 0 ?
+                (double) ln->resp_sum[l] / ln->resp_count[l] : 0;
+         work->burst[ln->rep[l]] = ln->burst_sum[l] / (ln->arr_cust[l] + 1);
+         work->iat[ln->rep[l]] = ln->iat_sum[l] / (ln->arr_cust[l] + 1);
+         free(ln->queue[l].job);
+         }
+  free(ln);
+  }
+
+/*********************************************************************/
+/* Name: Lane_burst                                                  */
+/* Description                                                       */
+/*    This function returns the burst time of customer cust of       */
+/* replication rep, drawn from the same uniforms Gen_arrival uses.   */
+/*********************************************************************/
+long int Lane_burst(struct Sim_parms *parms, unsigned long int rep, unsigned long int cust)
+  {
+  double v;
+  if(parms->burst_dist == NULL)
+         return(expon(parms->service_time,
+                      Counter_uniform(parms->seed, rep, FALSE, SERVICE_STREAM, cust, 0)));
+  v = parms->burst_dist->raw ?
+      Counter_uniform(parms->seed, rep, FALSE, SERVICE_STREAM, cust, 1) : 0;
+  return(Emp_draw(parms->burst_dist,
+                  Counter_uniform(parms->seed, rep, FALSE, SERVICE_STREAM, cust, 0), v));
+  }
+
+/*********************************************************************/
+/* Name: Lane_before                                                 */
+/* Description                                                       */
+/*    This function returns TRUE if lane job a leaves before job b:  */
+/* the shorter burst first, equal bursts in arrival order.           */
+/*********************************************************************/
+int Lane_before(struct Lane_job *a, struct Lane_job *b)
+  {
+  return(a->burst < b->burst || (a->burst == b->burst && a->cust < b->cust));
+  }
+
+/*********************************************************************/
+/* Name: Lane_push                                                   */
+/* Description                                                       */
+/*    This function adds a customer to a lane's SJF heap, growing    */
+/* the heap when it is full.  It returns FALSE, leaving the heap as  */
+/* it was, if memory runs out.                                       */
+/*********************************************************************/
+int Lane_push(struct Lane_queue *q, struct Lane_job *job)
+  {
+  long int i, parent, size;
+  struct Lane_job *grown;
+  if(q->n == q->size)
+         {
+         size = q->size ? 2 * q->size : 64;
+         grown = (struct Lane_job *) realloc(q->job, size * sizeof(struct Lane_job));
+         if(grown == NULL)
+                return(FALSE);
+         q->job = grown;
+         q->size = size;
+         }
+  /* sift up */
+  i = q->n++;
+  while(i > 0 && Lane_before(job, &q->job[parent = (i - 1) / 2]))
+         {
+         q->job[i] = q->job[parent];
+         i = parent;
+         }
+  q->job[i] = *job;
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Lane_pop                                                    */
+/* Description                                                       */
+/*    This procedure removes the shortest job from a lane's heap     */
+/* into job.  The heap must not be empty.                            */
+/*********************************************************************/
+void Lane_pop(struct Lane_queue *q, struct Lane_job *job)
+  {
+  long int i, child, last;
+  *job = q->job[0];
+  last = --q->n;
+  /* sift the last entry down from the root */
+  i = 0;
+  while((child = 2 * i + 1) < last)
+         {
+         if(child + 1 < last && Lane_before(&q->job[child + 1], &q->job[child]))
+                child++;
+         if(!Lane_before(&q->job[child], &q->job[last]))
+                break;
+         q->job[i] = q->job[child];
+         i = child;
+         }
+  q->job[i] = q->job[last];
+  }
+
+/*********************************************************************/
+/* Name: Run_shards                                                  */
+/* Description                                                       */
+/*    This procedure runs the sweep in separate worker processes,    */
+/* one per processor if procs is 0, so a point that runs away with   */
+/* memory takes down only its own worker.  The points and their      */
+/* result slots live in an anonymous shared mapping made before the  */
+/* fork.  Workers take points from an atomic cursor and claim each   */
+/* one by swapping its pid into the slot state, so no locks are      */
+/* needed.  When a worker dies the parent frees the points it held   */
+/* and starts a replacement; a point that has killed SHARD_TRIES     */
+/* workers is given up.  While the workers run the parent looks      */
+/* every SHARD_POLL milliseconds for finished points and writes the  */
+/* results and merges the histograms in point order up to the first  */
+/* point not yet finished, so the file grows as the sweep goes and   */
+/* is the same whatever the number of processes.                     */
+/*********************************************************************/
+void Run_shards(struct Sim_parms *parms, int procs)
+  {
+  struct Shard_region *region;
+  struct Shard_slot *slot;
+  struct Hdr_hist *all_hist;
+  struct timespec start, end, poll;
+  FILE *out;
+  size_t bytes;
+  double *point, elapsed;
+  long int npoint, k, done, failed, requeued, next;
+  int live, status;
+  pid_t pid;
+  point = Sweep_points(parms, &npoint);
+  procs = Pool_size(procs, npoint);
+  bytes = sizeof(struct Shard_region) + npoint * sizeof(struct Shard_slot);
+  region = (struct Shard_region *) mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  all_hist = (struct Hdr_hist *) malloc(sizeof(struct Hdr_hist));
+  if(region == MAP_FAILED || all_hist == NULL)
+         {
+         printf(" ***Error - cannot map the shared sweep region***\n");
+         exit(1);
+         }
+  region->npoint = npoint;
+  printf(" Sweeping %ld points in %d processes\n", npoint, procs);
+  out = Sweep_open(parms);
+  Hdr_init(all_hist);
+  next = 0;
+  poll.tv_sec = 0;
+  poll.tv_nsec = SHARD_POLL * 1000000L;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  live = 0;
+  while(live < procs && Shard_spawn(region, parms, point) > 0)
+         live++;
+  requeued = 0;
+  while(live > 0 && (pid = waitpid(-1, &status, WNOHANG)) >= 0)
+         {
+         next = Shard_flush(region, parms, point, out, all_hist, next, FALSE);
+         if(pid == 0)
+                {
+                nanosleep(&poll, NULL);
+                continue;
+                }
+         live--;
+         if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                {
+                /* the worker died - free or give up on the point it held */
+                for(k = 0; k < npoint; k++)
+                       {
+                       slot = &region->slot[k];
+                       if(__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != pid)
+                              continue;
+                       printf(" ***Warning - worker %d died running point %ld***\n",
+                              (int) pid, k);
+                       /* counted here, so a worker killed at any moment counts */
+                       if(++slot->tries >= SHARD_TRIES)
+                              __atomic_store_n(&slot->state, SLOT_FAILED, __ATOMIC_RELEASE);
+                       else
+                              {
+                              __atomic_store_n(&slot->state, SLOT_FREE, __ATOMIC_RELEASE);
+                              requeued++;
+                              }
+                       }
+                }
+         /* keep the pool full while any point is waiting */
+         while(live < procs && Shard_pending(region) && Shard_spawn(region, parms, point) > 0)
+                live++;
+         }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  /* points no worker could be started for are failed too */
+  Shard_flush(region, parms, point, out, all_hist, next, TRUE);
+  done = 0;
+  for(k = 0; k < npoint; k++)
+         done += (region->slot[k].state == SLOT_DONE);
+  failed = npoint - done;
+  if(out != stdout)
+         fclose(out);
+  printf("...Sweep ends\n");
+  printf(" points run / failed / requeued -> %ld / %ld / %ld\n", done, failed, requeued);
+  printf(" wall time / points/s -------> %.3f / %.1f\n", elapsed,
+         elapsed > 0 ? done / elapsed : 0);
+  Print_percentiles(parms, all_hist, "all points");
+  munmap(region, bytes);
+  free(all_hist);
+  if(point != parms->sweep->point)
+         free(point);
+  }
+
+/*********************************************************************/
+/* Name: Shard_flush                                                 */
+/* Description                                                       */
+/*    This function writes the results of every sweep point from     */
+/* next up to the first one not yet finished, merging their          */
+/* histograms, and returns the first point not written.  A point     */
+/* given up is written as failed; at the end (final TRUE) so is any  */
+/* point still not done.                                             */
+/*********************************************************************/
+long int Shard_flush(struct Shard_region *region, struct Sim_parms *parms, double *point,
+                     FILE *out, struct Hdr_hist *all_hist, long int next, int final)
+  {
+  struct Shard_slot *slot;
+  int state;
+  for(; next < region->npoint; next++)
+         {
+         slot = &region->slot[next];
+         state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+         if(state == SLOT_DONE)
+                {
+                Sweep_write(out, parms, point, next, &slot->res);
+                Hdr_merge(all_hist, &slot->hist);
+                }
+         else if(state == SLOT_FAILED || final)
+                fprintf(out, "# point %ld failed\n", next);
+         else
+                break;
+         }
+  fflush(out);
+  return(next);
+  }
+
+/*********************************************************************/
+/* Name: Shard_spawn                                                 */
+/* Description                                                       */
+/*    This function forks one sweep worker process and returns its   */
+/* pid, or -1 if the fork fails.  stdout is flushed first, so the    */
+/* child does not inherit lines the parent has yet to write, and the */
+/* child only ever leaves through _exit.  The child applies the      */
+/* memory limit on top of the address space it inherits, the shared */
+/* region included, runs points until none are left, and exits.     */
+/*********************************************************************/
+pid_t Shard_spawn(struct Shard_region *region, struct Sim_parms *parms, double *point)
+  {
+  struct rlimit lim;
+  struct Shard_slot *slot;
+  FILE *fp;
+  unsigned long int pages;
+  rlim_t base;
+  long int k;
+  int me;
+  pid_t pid;
+  fflush(stdout);
+  pid = fork();
+  if(pid < 0)
+         printf(" ***Error - cannot start a sweep worker process***\n");
+  if(pid != 0)
+         return(pid);
+  if(parms->mem_limit > 0)
+         {
+         /* what is mapped now, or at least the shared region */
+         base = sizeof(struct Shard_region) + region->npoint * sizeof(struct Shard_slot);
+         if((fp = fopen("/proc/self/statm", "r")) != NULL)
+                {
+                if(fscanf(fp, "%lu", &pages) == 1)
+                       base = (rlim_t) pages * sysconf(_SC_PAGESIZE);
+                fclose(fp);
+                }
+         lim.rlim_cur = lim.rlim_max = base + ((rlim_t) parms->mem_limit << 20);
+         if(setrlimit(RLIMIT_AS, &lim) != 0)
+                printf(" ***Warning - cannot limit worker %d to %ld MB***\n",
+                       (int) getpid(), parms->mem_limit);
+         }
+  me = (int) getpid();
+  while((k = Shard_claim(region, me)) >= 0)
+         {
+         slot = &region->slot[k];
+         if(!Sweep_run_point(parms, point, k, &slot->res, &slot->hist))
+                {
+                printf(" ***Error - out of memory***\n");
+                fflush(stdout);
+                _exit(1);
+                }
+         /* publish the results before the state says they are there */
+         __atomic_store_n(&slot->state, SLOT_DONE, __ATOMIC_RELEASE);
+         }
+  fflush(stdout);
+  _exit(0);
+  }
+
+/*********************************************************************/
+/* Name: Shard_claim                                                 */
+/* Description                                                       */
+/*    This function claims a sweep point for process me and returns  */
+/* it, or -1 if there is none.  Points never handed out come from    */
+/* the cursor; after that the slots are searched for points freed    */
+/* when a worker died.  A point is only taken by swapping the        */
+/* claimer's pid into a SLOT_FREE state, so each runs once at a time.*/
+/*********************************************************************/
+long int Shard_claim(struct Shard_region *region, int me)
+  {
+  long int k;
+  int expect;
+  while((k = __atomic_fetch_add(&region->cursor, 1, __ATOMIC_RELAXED)) < region->npoint)
+         {
+         expect = SLOT_FREE;
+         if(__atomic_compare_exchange_n(&region->slot[k].state, &expect, me, FALSE,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                return(k);
+         }
+  for(k = 0; k < region->npoint; k++)
+         {
+         expect = SLOT_FREE;
+         if(__atomic_compare_exchange_n(&region->slot[k].state, &expect, me, FALSE,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                return(k);
+         }
+  return(-1);
+  }
+
+/*********************************************************************/
+/* Name: Shard_pending                                               */
+/* Description                                                       */
+/*    This function returns TRUE if some sweep point is waiting for  */
+/* a worker.                                                         */
+/*********************************************************************/
+int Shard_pending(struct Shard_region *region)
+  {
+  long int k;
+  for(k = 0; k < region->npoint; k++)
+         if(__atomic_load_n(&region->slot[k].state, __ATOMIC_ACQUIRE) == SLOT_FREE)
+                return(TRUE);
+  return(FALSE);
+  }
+
+/*********************************************************************/
+/* Name: Run_network                                                 */
+/* Description                                                       */
+/*    This procedure simulates the network with one event list.      */
+/* Events are taken in (time, type, node, job) order until the end   */
+/* of simulation, and a job leaving a node is put straight back on   */
+/* the list as an arrival at the next node.                          */
+/*********************************************************************/
+void Run_network(struct Sim_parms *parms)
+  {
+  struct Net_model *net = parms->network;
+  struct Net_node *nodes;
+  struct Net_heap events;
+  struct Net_event ev;
+  struct Net_out out;
+  struct timespec start, end;
+  int i, k;
+  nodes = (struct Net_node *) malloc(net->nnode * sizeof(struct Net_node));
+  if(nodes == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  memset(&events, 0, sizeof(struct Net_heap));
+  printf(" Simulating a network of %d nodes\n", net->nnode);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < net->nnode; i++)
+         Net_init_node(net, parms, &nodes[i], i, &events);
+  while(events.n > 0 && events.ev[0].time < parms->sim_length)
+         {
+         Net_pop(&events, &ev);
+         Net_handle(net, parms, &nodes[ev.node], &ev, &out);
+         if(out.resp >= 0)
+                Hdr_record(&nodes[ev.node].resp_hist, out.resp);
+         for(k = 0; k < out.nlocal; k++)
+                Net_push(&events, &out.local[k]);
+         if(out.dest >= 0)
+                Net_push(&events, &out.msg);
+         }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  Net_report(parms, nodes);
+  printf(" wall time ------------------> %.3f\n",
+         (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+  for(i = 0; i < net->nnode; i++)
+         free(nodes[i].queue.job);
+  free(nodes);
+  free(events.ev);
+  }
+
+/*********************************************************************/
+/* Name: Run_network_parallel                                        */
+/* Description                                                       */
+/*    This procedure simulates the network with the conservative     */
+/* (Chandy-Misra-Bryant) engine.  Each node is a logical process     */
+/* with its own event list and queue, and jobs move between nodes as */
+/* messages on lock-free single producer, single consumer rings, one */
+/* per route.  A node only handles an event once no message can      */
+/* still arrive that comes before it, and it sends null messages     */
+/* carrying the earliest time it could next send a job, found from   */
+/* its minimum service time, so its neighbours need not wait for     */
+/* real traffic.  The nodes are dealt out to a pool of threads, one  */
+/* per processor if -t is not given, and each thread steps its nodes */
+/* in turn; a step never waits, so any number of nodes can share a  */
+/* thread.  Each node sees the same events in the same order as      */
+/* under Run_network, so the results are identical.                  */
+/*********************************************************************/
+void Run_network_parallel(struct Sim_parms *parms)
+  {
+  struct Net_model *net = parms->network;
+  struct Net_lp *lp;
+  struct Net_worker *work;
+  struct Net_node *nodes;
+  struct Spsc_ring *ring;
+  struct timespec start, end;
+  unsigned long long nulls;
+  int i, j, r, threads;
+  threads = Pool_size(parms->num_threads, net->nnode);
+  lp = (struct Net_lp *) calloc(net->nnode, sizeof(struct Net_lp));
+  work = (struct Net_worker *) malloc(threads * sizeof(struct Net_worker));
+  nodes = (struct Net_node *) malloc(net->nnode * sizeof(struct Net_node));
+  if(lp == NULL || work == NULL || nodes == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  for(i = 0; i < net->nnode; i++)
+         {
+         lp[i].net = net;
+         lp[i].parms = parms;
+         lp[i].in = (struct Spsc_ring **) calloc(net->nnode, sizeof(struct Spsc_ring *));
+         lp[i].in_clock = (long int *) calloc(net->nnode, sizeof(long int));
+         lp[i].to = (struct Spsc_ring **) calloc(net->nnode, sizeof(struct Spsc_ring *));
+         lp[i].sent = (long int *) calloc(net->nnode, sizeof(long int));
+         lp[i].blocked = (char *) calloc(net->nnode, sizeof(char));
+         if(lp[i].in == NULL || lp[i].in_clock == NULL || lp[i].to == NULL ||
+            lp[i].sent == NULL || lp[i].blocked == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         }
+  /* one channel for each pair of nodes joined by a route */
+  for(i = 0; i < net->nnode; i++)
+         for(r = 0; r < net->nroute[i]; r++)
+                {
+                j = net->dest[i][r];
+                if(j == i || lp[i].to[j] != NULL)
+                       continue;
+                ring = (struct Spsc_ring *) aligned_alloc(64, sizeof(struct Spsc_ring));
+                if(ring == NULL)
+                       {
+                       printf(" ***Error - out of memory***\n");
+                       exit(1);
+                       }
+                ring->head = ring->tail = 0;
+                lp[i].to[j] = ring;
+                lp[j].in[lp[j].nin++] = ring;
+                }
+  printf(" Simulating a network of %d nodes on %d threads\n", net->nnode, threads);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < net->nnode; i++)
+         Net_init_node(net, parms, &lp[i].node, i, &lp[i].events);
+  for(i = 0; i < threads; i++)
+         {
+         work[i].lp = lp;
+         work[i].first = i;
+         work[i].stride = threads;
+         work[i].nnode = net->nnode;
+         if(pthread_create(&work[i].thread, NULL, Net_worker_run, &work[i]) != 0)
+                {
+                printf(" ***Error - cannot start network thread %d***\n", i);
+                exit(1);
+                }
+         }
+  for(i = 0; i < threads; i++)
+         pthread_join(work[i].thread, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  nulls = 0;
+  for(i = 0; i < net->nnode; i++)
+         {
+         memcpy(&nodes[i], &lp[i].node, sizeof(struct Net_node));
+         nulls += lp[i].nulls;
+         }
+  Net_report(parms, nodes);
+  printf(" null messages sent ---------> %llu\n", nulls);
+  printf(" wall time ------------------> %.3f\n",
+         (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+  for(i = 0; i < net->nnode; i++)
+         {
+         for(j = 0; j < net->nnode; j++)
+                free(lp[i].to[j]);
+         free(lp[i].in);
+         free(lp[i].in_clock);
+         free(lp[i].to);
+         free(lp[i].sent);
+         free(lp[i].blocked);
+         free(lp[i].held);
+         free(lp[i].events.ev);
+         free(lp[i].node.queue.job);
+         }
+  free(lp);
+  free(work);
+  free(nodes);
+  }
+
+/*********************************************************************/
+/* Name: Net_worker_run                                              */
+/* Description                                                       */
+/*    This function is the body of one thread of the conservative    */
+/* engine.  It steps each of its logical processes in turn until     */
+/* every one has finished and sent all it held, yielding the         */
+/* processor after a round in which none of them could move.         */
+/*********************************************************************/
+void *Net_worker_run(void *arg)
+  {
+  struct Net_worker *work = (struct Net_worker *) arg;
+  struct Net_lp *lp;
+  int i, left, progressed;
+  do
+         {
+         left = 0;
+         progressed = FALSE;
+         for(i = work->first; i < work->nnode; i += work->stride)
+                {
+                lp = &work->lp[i];
+                if(lp->finished && lp->nheld == 0)
+                       continue;
+                left++;
+                if(Net_lp_step(lp))
+                       progressed = TRUE;
+                }
+         if(left > 0 && !progressed)
+                sched_yield();
+         }
+  while(left > 0);
+  return(NULL);
+  }
+
+/*********************************************************************/
+/* Name: Net_lp_step                                                 */
+/* Description                                                       */
+/*    This function takes one step of a logical process and returns  */
+/* TRUE if it got anywhere.  It sends what it could not send before, */
+/* takes in whatever its channels hold, handles every event that is  */
+/* safe, and sends its neighbours a new bound.  Once it has nothing  */
+/* left to do before the end of simulation it sends its last bounds  */
+/* and is finished.  An event is safe when it is before the clock of */
+/* every channel in, or at that time and a departure or arrival -    */
+/* arrivals at the same time can be taken in any order, but a        */
+/* service start must wait for all of them.                          */
+/*********************************************************************/
+int Net_lp_step(struct Net_lp *lp)
+  {
+  struct Net_event ev, *top;
+  struct Net_out out;
+  long int min_in, bound, end;
+  int j, k, progressed;
+  progressed = Net_flush(lp);
+  if(lp->finished)
+         return(progressed);
+  end = lp->parms->sim_length;
+  min_in = Net_drain(lp);
+  while(lp->events.n > 0 && (top = &lp->events.ev[0])->time < end &&
+        (top->time < min_in || (top->time == min_in && top->type <= NET_ARRIVE)))
+         {
+         Net_pop(&lp->events, &ev);
+         Net_handle(lp->net, lp->parms, &lp->node, &ev, &out);
+         if(out.resp >= 0)
+                Hdr_record(&lp->node.resp_hist, out.resp);
+         for(k = 0; k < out.nlocal; k++)
+                Net_push(&lp->events, &out.local[k]);
+         if(out.dest == lp->node.index)
+                Net_push(&lp->events, &out.msg);
+         else if(out.dest >= 0)
+                Net_send(lp, out.dest, out.msg.time, &out.msg.job);
+         progressed = TRUE;
+         }
+  /* tell the neighbours how far they may go */
+  bound = Net_bound(lp, min_in);
+  for(j = 0; j < lp->net->nnode; j++)
+         if(lp->to[j] != NULL && bound > lp->sent[j])
+                {
+                Net_send(lp, j, bound, NULL);
+                lp->nulls++;
+                progressed = TRUE;
+                }
+  if((lp->events.n == 0 || lp->events.ev[0].time >= end) && min_in >= end)
+         {
+         /* nothing more will be sent */
+         for(j = 0; j < lp->net->nnode; j++)
+                if(lp->to[j] != NULL && lp->sent[j] < MAXLONG)
+                       Net_send(lp, j, MAXLONG, NULL);
+         lp->finished = TRUE;
+         progressed = TRUE;
+         }
+  return(progressed);
+  }
+
+/*********************************************************************/
+/* Name: Net_drain                                                   */
+/* Description                                                       */
+/*    This function moves every message waiting on a logical         */
+/* process's channels into its event list, updates the channel       */
+/* clocks, and returns the smallest of them (MAXLONG if the node has */
+/* no channels in).  Messages on one channel come in time order, so  */
+/* nothing earlier than a channel's clock can still arrive on it.    */
+/*********************************************************************/
+long int Net_drain(struct Net_lp *lp)
+  {
+  struct Net_msg msg;
+  struct Net_event ev;
+  long int min_in;
+  int c;
+  min_in = MAXLONG;
+  for(c = 0; c < lp->nin; c++)
+         {
+         while(Spsc_pop(lp->in[c], &msg))
+                {
+                lp->in_clock[c] = msg.time;
+                if(msg.job.hop < 0)
+                       continue;
+                ev.time = msg.time;
+                ev.type = NET_ARRIVE;
+                ev.node = lp->node.index;
+                ev.job = msg.job;
+                Net_push(&lp->events, &ev);
+                }
+         if(lp->in_clock[c] < min_in)
+                min_in = lp->in_clock[c];
+         }
+  return(min_in);
+  }
+
+/*********************************************************************/
+/* Name: Net_send                                                    */
+/* Description                                                       */
+/*    This procedure sends a job, or a null message if job is NULL,  */
+/* to node dest at the given time.  If the channel is full, or       */
+/* earlier messages are still waiting, the message waits in the      */
+/* sender's held list for Net_flush, so a sender never blocks.       */
+/*********************************************************************/
+void Net_send(struct Net_lp *lp, int dest, long int time, struct Net_job *job)
+  {
+  struct Net_msg msg;
+  struct Net_held *grown;
+  long int size;
+  msg.time = time;
+  if(job != NULL)
+         msg.job = *job;
+  else
+         {
+         memset(&msg.job, 0, sizeof(struct Net_job));
+         msg.job.hop = -1;
+         }
+  if(time > lp->sent[dest])
+         lp->sent[dest] = time;
+  if(lp->nheld == 0 && Spsc_push(lp->to[dest], &msg))
+         return;
+  if(lp->nheld == lp->held_size)
+         {
+         size = lp->held_size ? 2 * lp->held_size : 64;
+         grown = (struct Net_held *) realloc(lp->held, size * sizeof(struct Net_held));
+         if(grown == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         lp->held = grown;
+         lp->held_size = size;
+         }
+  lp->held[lp->nheld].dest = dest;
+  lp->held[lp->nheld++].msg = msg;
+  }
+
+/*********************************************************************/
+/* Name: Net_flush                                                   */
+/* Description                                                       */
+/*    This function sends the held messages of a logical process     */
+/* that now fit, in order, and returns TRUE if it sent any.  Once a  */
+/* channel is found full the rest of its messages stay behind, so    */
+/* each channel still delivers in the order things were sent.        */
+/*********************************************************************/
+int Net_flush(struct Net_lp *lp)
+  {
+  struct Net_held *h;
+  long int k, kept;
+  int moved;
+  moved = FALSE;
+  kept = 0;
+  for(k = 0; k < lp->nheld; k++)
+         {
+         h = &lp->held[k];
+         if(!lp->blocked[h->dest] && Spsc_push(lp->to[h->dest], &h->msg))
+                {
+                moved = TRUE;
+                continue;
+                }
+         lp->blocked[h->dest] = TRUE;
+         lp->held[kept++] = *h;
+         }
+  lp->nheld = kept;
+  for(k = 0; k < kept; k++)
+         lp->blocked[lp->held[k].dest] = FALSE;
+  return(moved);
+  }
+
+/*********************************************************************/
+/* Name: Net_bound                                                   */
+/* Description                                                       */
+/*    This function returns the earliest time a logical process can  */
+/* still send a job.  A busy server sends its job when it leaves.   */
+/* An idle one has to start a job first, no earlier than its next    */
+/* event or the next message in, and service takes at least the      */
+/* node's lookahead.                                                 */
+/*********************************************************************/
+long int Net_bound(struct Net_lp *lp, long int min_in)
+  {
+  long int t;
+  if(lp->node.st.busy)
+         return(lp->node.st.depart_time);
+  t = min_in;
+  if(lp->events.n > 0 && lp->events.ev[0].time < t)
+         t = lp->events.ev[0].time;
+  if(t >= lp->parms->sim_length)
+         return(MAXLONG);
+  return(t + lp->net->lookahead[lp->node.index]);
+  }
+
+/*********************************************************************/
+/* Name: Net_init_node                                               */
+/* Description                                                       */
+/*    This procedure sets node i up empty and idle, and puts its     */
+/* first external arrival, if it has any, on the given event list.   */
+/*********************************************************************/
+void Net_init_node(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                   int i, struct Net_heap *events)
+  {
+  struct Net_event ev;
+  memset(nd, 0, sizeof(struct Net_node));
+  nd->index = i;
+  Hdr_init(&nd->resp_hist);
+  if(net->iarrive[i] <= 0)
+         return;
+  memset(&ev, 0, sizeof(struct Net_event));
+  ev.time = expon(net->iarrive[i], Counter_uniform(parms->seed, 0, FALSE, NET_ARRIVAL_STREAM,
+                                                   (unsigned long long) i << 40, 0));
+  ev.type = NET_EXTERNAL;
+  ev.node = i;
+  Net_push(events, &ev);
+  }
+
+/*********************************************************************/
+/* Name: Net_handle                                                  */
+/* Description                                                       */
+/*    This procedure handles one event at a node and says in out     */
+/* what it led to: events the node schedules for itself, and the     */
+/* arrival of a departing job at its next node.  The node's state    */
+/* depends only on the events it has seen, and every random number   */
+/* is keyed by job and hop, so the engine driving it makes no        */
+/* difference to the results.  The network time of a job leaving is */
+/* returned in out rather than recorded, so an engine that may undo  */
+/* the event can record it once the event is final.                  */
+/*********************************************************************/
+void Net_handle(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                struct Net_event *ev, struct Net_out *out)
+  {
+  struct Net_job job;
+  struct Net_event *loc;
+  long int t = ev->time;
+  double u;
+  int i = nd->index, r;
+  out->nlocal = 0;
+  out->dest = -1;
+  out->resp = -1;
+  switch (ev->type)
+        {
+        case NET_EXTERNAL :
+                /* a new job enters, and the next one is scheduled */
+                memset(&job, 0, sizeof(struct Net_job));
+                job.id = ((unsigned long long) i << 40) | nd->st.next_ext++;
+                job.entry = t;
+                Net_enqueue(net, parms, nd, &job, t, out);
+                loc = &out->local[out->nlocal++];
+                memset(loc, 0, sizeof(struct Net_event));
+                loc->time = t + expon(net->iarrive[i],
+                                      Counter_uniform(parms->seed, 0, FALSE, NET_ARRIVAL_STREAM,
+                                                      ((unsigned long long) i << 40) | nd->st.next_ext, 0));
+                loc->type = NET_EXTERNAL;
+                loc->node = i;
+                break;
+        case NET_ARRIVE :
+                job = ev->job;
+                Net_enqueue(net, parms, nd, &job, t, out);
+                break;
+        case NET_START :
+                nd->st.start_pending = FALSE;
+                if(nd->st.busy || nd->queue.n == 0)
+                       break;
+                Netq_pop(&nd->queue, &nd->st.serving);
+                nd->st.busy = TRUE;
+                nd->st.depart_time = t + nd->st.serving.burst;
+                nd->st.started++;
+                nd->st.wait_sum += t - nd->st.serving.arrive;
+                nd->st.busy_ticks += (nd->st.depart_time < parms->sim_length) ?
+                                  nd->st.serving.burst : parms->sim_length - t;
+                loc = &out->local[out->nlocal++];
+                loc->time = nd->st.depart_time;
+                loc->type = NET_DEPART;
+                loc->node = i;
+                loc->job = nd->st.serving;
+                break;
+        case NET_DEPART :
+                nd->st.busy = FALSE;
+                job = nd->st.serving;
+                nd->st.served++;
+                nd->st.sojourn_sum += t - job.arrive;
+                /* route the job on, or out of the network */
+                u = Counter_uniform(parms->seed, 0, FALSE, NET_ROUTE_STREAM, job.id, job.hop);
+                for(r = 0; r < net->nroute[i] && u >= net->cum[i][r]; r++)
+                       ;
+                if(r == net->nroute[i])
+                       {
+                       nd->st.exits++;
+                       nd->st.resp_sum += t - job.entry;
+                       out->resp = t - job.entry;
+                       }
+                else
+                       {
+                       job.hop++;
+                       out->dest = net->dest[i][r];
+                       out->msg.time = t;
+                       out->msg.type = NET_ARRIVE;
+                       out->msg.node = out->dest;
+                       out->msg.job = job;
+                       }
+                if(nd->queue.n > 0 && !nd->st.start_pending)
+                       {
+                       nd->st.start_pending = TRUE;
+                       loc = &out->local[out->nlocal++];
+                       memset(loc, 0, sizeof(struct Net_event));
+                       loc->time = t;
+                       loc->type = NET_START;
+                       loc->node = i;
+                       }
+                break;
+        default :
+                printf(" ***Error - invalid network event type***\n");
+        }
+  }
+
+/*********************************************************************/
+/* Name: Net_enqueue                                                 */
+/* Description                                                       */
+/*    This procedure puts a job arriving at a node in its SJF queue, */
+/* drawing its service time there: the node's minimum plus an        */
+/* exponential part.  If the server is idle a service start is       */
+/* scheduled for the end of the time step.                           */
+/*********************************************************************/
+void Net_enqueue(struct Net_model *net, struct Sim_parms *parms, struct Net_node *nd,
+                 struct Net_job *job, long int t, struct Net_out *out)
+  {
+  struct Net_event *loc;
+  int i = nd->index;
+  job->arrive = t;
+  job->burst = net->min_ticks[i] +
+               expon(net->service[i] - net->min_service[i],
+                     Counter_uniform(parms->seed, 0, FALSE, NET_SERVICE_STREAM, job->id, job->hop));
+  Netq_push(&nd->queue, job);
+  if(!nd->st.busy && !nd->st.start_pending)
+         {
+         nd->st.start_pending = TRUE;
+         loc = &out->local[out->nlocal++];
+         memset(loc, 0, sizeof(struct Net_event));
+         loc->time = t;
+         loc->type = NET_START;
+         loc->node = i;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Net_report                                                  */
+/* Description                                                       */
+/*    This procedure prints the statistics of each node and of the   */
+/* jobs that passed through the network.                             */
+/*********************************************************************/
+void Net_report(struct Sim_parms *parms, struct Net_node *nodes)
+  {
+  struct Net_model *net = parms->network;
+  struct Hdr_hist *all_hist;
+  unsigned long long exits, resp_sum;
+  int i;
+  all_hist = (struct Hdr_hist *) malloc(sizeof(struct Hdr_hist));
+  if(all_hist == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  Hdr_init(all_hist);
+  exits = 0;
+  resp_sum = 0;
+  printf("...Simulation ends\n");
+  printf(" node  served  mean sojourn  mean wait  utilization\n");
+  for(i = 0; i < net->nnode; i++)
+         {
+         printf(" %4d %7llu %13.3f %10.3f %12.4f\n", i, nodes[i].st.served,
+                nodes[i].st.served ? nodes[i].st.sojourn_sum / 100.0 / nodes[i].st.served : 0,
+                nodes[i].st.started ? nodes[i].st.wait_sum / 100.0 / nodes[i].st.started : 0,
+                (double) nodes[i].st.busy_ticks / parms->sim_length);
+         exits += nodes[i].st.exits;
+         resp_sum += nodes[i].st.resp_sum;
+         Hdr_merge(all_hist, &nodes[i].resp_hist);
+         }
+  printf(" jobs through the network ---> %llu\n", exits);
+  printf(" mean response time ---------> %-6.3f\n",
+         exits ? resp_sum / 100.0 / exits : 0);
+  Print_percentiles(parms, all_hist, "response time");
+  free(all_hist);
+  }
+
+/*********************************************************************/
+/* Name: Net_before                                                  */
+/* Description                                                       */
+/*    This function returns TRUE if network event a comes before b:  */
+/* by time, then type, node and job id.                              */
+/*********************************************************************/
+int Net_before(struct Net_event *a, struct Net_event *b)
+  {
+  if(a->time != b->time)
+         return(a->time < b->time);
+  if(a->type != b->type)
+         return(a->type < b->type);
+  if(a->node != b->node)
+         return(a->node < b->node);
+  return(a->job.id < b->job.id);
+  }
+
+/*********************************************************************/
+/* Name: Net_push                                                    */
+/* Description                                                       */
+/*    This procedure adds an event to a network event heap.  Running */
+/* out of memory ends the program, as for any other event list.      */
+/*********************************************************************/
+void Net_push(struct Net_heap *h, struct Net_event *ev)
+  {
+  struct Net_event *grown;
+  long int i, parent;
+  if(h->n == h->size)
+         {
+         grown = (struct Net_event *) realloc(h->ev, (h->size ? 2 * h->size : 64) *
+                                              sizeof(struct Net_event));
+         if(grown == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         h->ev = grown;
+         h->size = h->size ? 2 * h->size : 64;
+         }
+  i = h->n++;
+  while(i > 0 && Net_before(ev, &h->ev[parent = (i - 1) / 2]))
+         {
+         h->ev[i] = h->ev[parent];
+         i = parent;
+         }
+  h->ev[i] = *ev;
+  }
+
+/*********************************************************************/
+/* Name: Net_pop                                                     */
+/* Description                                                       */
+/*    This procedure removes the first event from a network event    */
+/* heap into ev, then clears any cancelled events off the top, so    */
+/* the first event is always a live one.  The heap must not be       */
+/* empty.                                                            */
+/*********************************************************************/
+void Net_pop(struct Net_heap *h, struct Net_event *ev)
+  {
+  *ev = h->ev[0];
+  Net_drop_top(h);
+  while(h->n > 0 && h->cancel.used > 0 && Net_cancel_take(&h->cancel, &h->ev[0]))
+         Net_drop_top(h);
+  }
+
+/*********************************************************************/
+/* Name: Net_drop_top                                                */
+/* Description                                                       */
+/*    This procedure removes the first event from a network event    */
+/* heap, the last event sifting down from the top to fill its place. */
+/*********************************************************************/
+void Net_drop_top(struct Net_heap *h)
+  {
+  struct Net_event last;
+  long int i, child;
+  last = h->ev[--h->n];
+  i = 0;
+  while((child = 2 * i + 1) < h->n)
+         {
+         if(child + 1 < h->n && Net_before(&h->ev[child + 1], &h->ev[child]))
+                child++;
+         if(!Net_before(&h->ev[child], &last))
+                break;
+         h->ev[i] = h->ev[child];
+         i = child;
+         }
+  h->ev[i] = last;
+  }
+
+/*********************************************************************/
+/* Name: Net_remove                                                  */
+/* Description                                                       */
+/*    This procedure takes a given event, which must be there, out   */
+/* of a network event heap, matching it by time, type, node, job id  */
+/* and hop.  The first event is popped; any other is only marked     */
+/* cancelled, and dropped when it reaches the top, so nothing is     */
+/* searched for.                                                     */
+/*********************************************************************/
+void Net_remove(struct Net_heap *h, struct Net_event *ev)
+  {
+  struct Net_event first;
+  if(Net_same(&h->ev[0], ev))
+         Net_pop(h, &first);
+  else
+         Net_cancel_add(&h->cancel, ev);
+  }
+
+/*********************************************************************/
+/* Name: Netq_push                                                   */
+/* Description                                                       */
+/*    This procedure adds a job to a node's SJF queue, which is kept */
+/* as a heap ordered by service time and then job id.  Running out  */
+/* of memory ends the program.                                       */
+/*********************************************************************/
+void Netq_push(struct Net_queue *q, struct Net_job *job)
+  {
+  struct Net_job *grown;
+  long int i, parent;
+  if(q->n == q->size)
+         {
+         grown = (struct Net_job *) realloc(q->job, (q->size ? 2 * q->size : 64) *
+                                            sizeof(struct Net_job));
+         if(grown == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         q->job = grown;
+         q->size = q->size ? 2 * q->size : 64;
+         }
+  i = q->n++;
+  while(i > 0 && (q->job[parent = (i - 1) / 2].burst > job->burst ||
+                  (q->job[parent].burst == job->burst && q->job[parent].id > job->id)))
+         {
+         q->job[i] = q->job[parent];
+         i = parent;
+         }
+  q->job[i] = *job;
+  }
+
+/*********************************************************************/
+/* Name: Netq_pop                                                    */
+/* Description                                                       */
+/*    This procedure removes the shortest job from a node's SJF      */
+/* queue into job, then clears any cancelled jobs off the top.  The  */
+/* queue must not be empty.                                          */
+/*********************************************************************/
+void Netq_pop(struct Net_queue *q, struct Net_job *job)
+  {
+  struct Net_event dead;
+  *job = q->job[0];
+  Netq_drop_top(q);
+  if(q->cancel.used == 0)
+         return;
+  memset(&dead, 0, sizeof(struct Net_event));
+  while(q->n > 0)
+         {
+         dead.time = q->job[0].arrive;
+         dead.job.id = q->job[0].id;
+         dead.job.hop = q->job[0].hop;
+         if(!Net_cancel_take(&q->cancel, &dead))
+                break;
+         Netq_drop_top(q);
+         }
+  }
+
+/*********************************************************************/
+/* Name: Netq_drop_top                                               */
+/* Description                                                       */
+/*    This procedure removes the shortest job from a node's SJF      */
+/* queue, the last job sifting down from the top to fill its place.  */
+/*********************************************************************/
+void Netq_drop_top(struct Net_queue *q)
+  {
+  struct Net_job last;
+  long int i, child;
+  last = q->job[--q->n];
+  i = 0;
+  while((child = 2 * i + 1) < q->n)
+         {
+         if(child + 1 < q->n && (q->job[child + 1].burst < q->job[child].burst ||
+                                 (q->job[child + 1].burst == q->job[child].burst &&
+                                  q->job[child + 1].id < q->job[child].id)))
+                child++;
+         if(q->job[child].burst > last.burst ||
+            (q->job[child].burst == last.burst && q->job[child].id > last.id))
+                break;
+         q->job[i] = q->job[child];
+         i = child;
+         }
+  q->job[i] = last;
+  }
+
+/*********************************************************************/
+/* Name: Netq_remove                                                 */
+/* Description                                                       */
+/*    This procedure takes the job with the given id and hop that    */
+/* arrived at the given time, which must be there, out of a node's   */
+/* SJF queue, in the same way as Net_remove.  The hop and time       */
+/* matter: under Time Warp a job may be queued twice at a node in a  */
+/* speculative past that is later undone.                            */
+/*********************************************************************/
+void Netq_remove(struct Net_queue *q, unsigned long long id, int hop, long int arrive)
+  {
+  struct Net_event dead;
+  struct Net_job first;
+  if(q->job[0].id == id && q->job[0].hop == hop && q->job[0].arrive == arrive)
+         Netq_pop(q, &first);
+  else
+         {
+         memset(&dead, 0, sizeof(struct Net_event));
+         dead.time = arrive;
+         dead.job.id = id;
+         dead.job.hop = hop;
+         Net_cancel_add(&q->cancel, &dead);
+         }
+  }
+
+/*********************************************************************/
+/* Name: Net_same                                                    */
+/* Description                                                       */
+/*    This function returns TRUE if two network events are the same: */
+/* the same time, type, node, job id and hop.                        */
+/*********************************************************************/
+int Net_same(struct Net_event *a, struct Net_event *b)
+  {
+  return(a->time == b->time && a->type == b->type && a->node == b->node &&
+         a->job.id == b->job.id && a->job.hop == b->job.hop);
+  }
+
+/*********************************************************************/
+/* Name: Net_cancel_slot                                             */
+/* Description                                                       */
+/*    This function returns the slot of a cancelled set that holds   */
+/* ev, or else the free slot where it would go: the first slot from  */
+/* its hash on that matches it or is free.                           */
+/*********************************************************************/
+long int Net_cancel_slot(struct Net_cancel *c, struct Net_event *ev)
+  {
+  long int t, mask = c->size - 1;
+  t = (long int) (Mix64(Mix64(ev->job.id) ^ ((unsigned long long) ev->time << 8) ^
+                        ((unsigned long long) ev->type << 4) ^
+                        ((unsigned long long) ev->node << 40) ^
+                        ((unsigned long long) (unsigned int) ev->job.hop << 20)) & mask);
+  while(c->dead[t].count > 0 && !Net_same(&c->dead[t].ev, ev))
+         t = (t + 1) & mask;
+  return(t);
+  }
+
+/*********************************************************************/
+/* Name: Net_cancel_add                                              */
+/* Description                                                       */
+/*    This procedure adds a copy of ev to a cancelled set.  The      */
+/* table doubles when it is half full, so searches stay short.       */
+/* Running out of memory ends the program.                           */
+/*********************************************************************/
+void Net_cancel_add(struct Net_cancel *c, struct Net_event *ev)
+  {
+  struct Net_dead *old;
+  long int t, k, size;
+  if(2 * (c->used + 1) > c->size)
+         {
+         old = c->dead;
+         size = c->size;
+         c->size = size ? 2 * size : 16;
+         c->dead = (struct Net_dead *) calloc(c->size, sizeof(struct Net_dead));
+         if(c->dead == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         for(k = 0; k < size; k++)
+                if(old[k].count > 0)
+                       c->dead[Net_cancel_slot(c, &old[k].ev)] = old[k];
+         free(old);
+         }
+  t = Net_cancel_slot(c, ev);
+  if(c->dead[t].count++ == 0)
+         {
+         c->dead[t].ev = *ev;
+         c->used++;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Net_cancel_take                                             */
+/* Description                                                       */
+/*    This function takes a copy of ev out of a cancelled set,       */
+/* returning FALSE if there is none.  When the last copy goes, the   */
+/* entries after it that could no longer be found from their hash    */
+/* are moved back into the gap.                                      */
+/*********************************************************************/
+int Net_cancel_take(struct Net_cancel *c, struct Net_event *ev)
+  {
+  long int gap, t, mask = c->size - 1;
+  gap = Net_cancel_slot(c, ev);
+  if(c->dead[gap].count == 0)
+         return(FALSE);
+  if(--c->dead[gap].count > 0)
+         return(TRUE);
+  c->used--;
+  for(t = (gap + 1) & mask; c->dead[t].count > 0; t = (t + 1) & mask)
+         {
+         /* the search for it stops at the gap if it belongs there */
+         if(Net_cancel_slot(c, &c->dead[t].ev) == t)
+                continue;
+         c->dead[gap] = c->dead[t];
+         c->dead[t].count = 0;
+         gap = t;
+         }
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Spsc_push                                                   */
+/* Description                                                       */
+/*    This function adds a message to a ring, returning FALSE if it  */
+/* is full.  Only the producer calls it.  The message is written     */
+/* before the release store of tail makes it visible.                */
+/*********************************************************************/
+int Spsc_push(struct Spsc_ring *ring, struct Net_msg *msg)
+  {
+  unsigned long tail, head;
+  tail = ring->tail;
+  head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  if(tail - head == NET_RING)
+         return(FALSE);
+  ring->buf[tail & (NET_RING - 1)] = *msg;
+  __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Spsc_pop                                                    */
+/* Description                                                       */
+/*    This function takes the oldest message from a ring into msg,   */
+/* returning FALSE if it is empty.  Only the consumer calls it.      */
+/*********************************************************************/
+int Spsc_pop(struct Spsc_ring *ring, struct Net_msg *msg)
+  {
+  unsigned long head, tail;
+  head = ring->head;
+  tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  if(head == tail)
+         return(FALSE);
+  *msg = ring->buf[head & (NET_RING - 1)];
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Run_network_timewarp                                        */
+/* Description                                                       */
+/*    This procedure simulates the network with the optimistic (Time */
+/* Warp) engine.  Each node is a logical process with its own event  */
+/* list and queue, and the nodes are dealt out in blocks to a pool   */
+/* of threads.  A thread handles the earliest event of its nodes     */
+/* without waiting to learn whether it is safe, keeping a record of  */
+/* the node's state before each event.  A job that arrives in a      */
+/* node's past undoes the events after it, and anti-messages cancel  */
+/* the jobs those events sent.  Undoing cancels pending events and   */
+/* queued jobs without searching for them.  Now and then the         */
+/* threads find the global virtual time (GVT), the earliest time     */
+/* anything can still happen, without stopping (see Tw_gvt), and     */
+/* commit the records before it.  Committed events are the ones      */
+/* Run_network handles, so the results are identical.                */
+/*********************************************************************/
+void Run_network_timewarp(struct Sim_parms *parms, int threads)
+  {
+  struct Net_model *net = parms->network;
+  struct Tw_engine eng;
+  struct Net_node *nodes;
+  struct Tw_msg *msg;
+  struct timespec start, end;
+  unsigned long long handled, undone, rollbacks, antis;
+  int i, w;
+  threads = Pool_size(threads, net->nnode);
+  eng.net = net;
+  eng.parms = parms;
+  eng.nthread = threads;
+  eng.lp = (struct Tw_lp *) calloc(net->nnode, sizeof(struct Tw_lp));
+  eng.owner = (int *) malloc(net->nnode * sizeof(int));
+  eng.th = (struct Tw_thread *) aligned_alloc(64, threads * sizeof(struct Tw_thread));
+  if(eng.lp == NULL || eng.owner == NULL || eng.th == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  memset(eng.th, 0, threads * sizeof(struct Tw_thread));
+  for(w = 0; w < threads; w++)
+         {
+         eng.th[w].eng = &eng;
+         eng.th[w].lo = (int) ((long int) w * net->nnode / threads);
+         eng.th[w].hi = (int) ((long int) (w + 1) * net->nnode / threads);
+         for(i = eng.th[w].lo; i < eng.th[w].hi; i++)
+                eng.owner[i] = w;
+         }
+  pthread_mutex_init(&eng.gvt_lock, NULL);
+  eng.round = eng.joined = eng.reported = 0;
+  eng.phase = TW_IDLE;
+  eng.round_min = MAXLONG;
+  eng.gvt = 0;
+  eng.finished = 0;
+  printf(" Simulating a network of %d nodes on %d threads with Time Warp\n",
+         net->nnode, threads);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < net->nnode; i++)
+         Net_init_node(net, parms, &eng.lp[i].node, i, &eng.lp[i].pending);
+  for(w = 0; w < threads; w++)
+         {
+         eng.th[w].sched = (int *) malloc((eng.th[w].hi - eng.th[w].lo) * sizeof(int));
+         for(i = eng.th[w].lo; i < eng.th[w].hi; i++)
+                {
+                eng.lp[i].slot = eng.th[w].nsched++;
+                Tw_resched(&eng.th[w], &eng.lp[i]);
+                }
+         }
+  for(w = 0; w < threads; w++)
+         if(pthread_create(&eng.th[w].thread, NULL, Tw_run, &eng.th[w]) != 0)
+                {
+                printf(" ***Error - cannot start Time Warp thread %d***\n", w);
+                exit(1);
+                }
+  handled = undone = rollbacks = antis = 0;
+  for(w = 0; w < threads; w++)
+         {
+         pthread_join(eng.th[w].thread, NULL);
+         handled += eng.th[w].handled;
+         undone += eng.th[w].undone;
+         rollbacks += eng.th[w].rollbacks;
+         antis += eng.th[w].antis;
+         }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  nodes = (struct Net_node *) malloc(net->nnode * sizeof(struct Net_node));
+  for(i = 0; i < net->nnode; i++)
+         memcpy(&nodes[i], &eng.lp[i].node, sizeof(struct Net_node));
+  Net_report(parms, nodes);
+  printf(" events handled -------------> %llu\n", handled);
+  printf(" events rolled back ---------> %llu\n", undone);
+  printf(" rollbacks ------------------> %llu\n", rollbacks);
+  printf(" anti-messages sent ---------> %llu\n", antis);
+  printf(" GVT rounds -----------------> %d\n", eng.finished);
+  printf(" wall time ------------------> %.3f\n",
+         (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+  pthread_mutex_destroy(&eng.gvt_lock);
+  for(w = 0; w < threads; w++)
+         {
+         /* messages sent after the last round, all at or past the end */
+         while((msg = eng.th[w].inbox) != NULL)
+                {
+                eng.th[w].inbox = msg->next;
+                free(msg);
+                }
+         while((msg = eng.th[w].head) != NULL)
+                {
+                eng.th[w].head = msg->next;
+                free(msg);
+                }
+         while((msg = eng.th[w].spare) != NULL)
+                {
+                eng.th[w].spare = msg->next;
+                free(msg);
+                }
+         free(eng.th[w].sched);
+         }
+  for(i = 0; i < net->nnode; i++)
+         {
+         free(eng.lp[i].pending.ev);
+         free(eng.lp[i].node.queue.job);
+         free(eng.lp[i].pending.cancel.dead);
+         free(eng.lp[i].node.queue.cancel.dead);
+         free(eng.lp[i].log);
+         }
+  free(eng.lp);
+  free(eng.owner);
+  free(eng.th);
+  free(nodes);
+  }
+
+/*********************************************************************/
+/* Name: Tw_run                                                      */
+/* Description                                                       */
+/*    This function is the body of one Time Warp thread.  It takes   */
+/* in its messages and handles the next event of the node at the top */
+/* of its heap, while there is one before the end of simulation and  */
+/* its share of TW_BATCH events for the GVT round is not used up.    */
+/* After each event, or pass with nothing to do, it plays its part   */
+/* in the round and commits what it can whenever the GVT moves.  It  */
+/* stops once the GVT reaches the end of simulation.  A thread with  */
+/* nothing to do yields, so the others can get on when there are     */
+/* fewer processors than threads.                                    */
+/*********************************************************************/
+void *Tw_run(void *arg)
+  {
+  struct Tw_thread *th = (struct Tw_thread *) arg;
+  struct Tw_engine *eng = th->eng;
+  struct Tw_lp *next;
+  long int end, gvt;
+  int idle;
+  end = eng->parms->sim_length;
+  while(TRUE)
+         {
+         Tw_drain(th);
+         next = &eng->lp[th->sched[0]];
+         idle = next->pending.n == 0 || next->pending.ev[0].time >= end;
+         if(idle)
+                th->batch = TW_BATCH;
+         else if(th->batch < TW_BATCH)
+                {
+                Tw_handle(th, next);
+                Tw_resched(th, next);
+                th->batch++;
+                }
+         gvt = Tw_gvt(th);
+         if(gvt > th->gvt)
+                {
+                Tw_fossil(th, gvt);
+                th->gvt = gvt;
+                }
+         if(gvt >= end)
+                break;
+         if(th->batch >= TW_BATCH)
+                sched_yield();
+         }
+  return(NULL);
+  }
+
+/*********************************************************************/
+/* Name: Tw_handle                                                   */
+/* Description                                                       */
+/*    This procedure handles the earliest pending event of a node    */
+/* speculatively, recording the node's state before it and what it   */
+/* led to so that it can be undone.                                  */
+/*********************************************************************/
+void Tw_handle(struct Tw_thread *th, struct Tw_lp *lp)
+  {
+  struct Tw_engine *eng = th->eng;
+  struct Tw_record *rec;
+  struct Tw_record *grown;
+  int k;
+  if(lp->nlog == lp->size)
+         {
+         grown = (struct Tw_record *) realloc(lp->log, (lp->size ? 2 * lp->size : 64) *
+                                              sizeof(struct Tw_record));
+         if(grown == NULL)
+                {
+                printf(" ***Error - out of memory***\n");
+                exit(1);
+                }
+         lp->log = grown;
+         lp->size = lp->size ? 2 * lp->size : 64;
+         }
+  rec = &lp->log[lp->nlog++];
+  Net_pop(&lp->pending, &rec->ev);
+  rec->saved = lp->node.st;
+  Net_handle(eng->net, eng->parms, &lp->node, &rec->ev, &rec->out);
+  for(k = 0; k < rec->out.nlocal; k++)
+         Net_push(&lp->pending, &rec->out.local[k]);
+  if(rec->out.dest == lp->node.index)
+         Net_push(&lp->pending, &rec->out.msg);
+  else if(rec->out.dest >= 0)
+         Tw_send(th, &rec->out.msg, FALSE);
+  th->handled++;
+  }
+
+/*********************************************************************/
+/* Name: Tw_earlier                                                  */
+/* Description                                                       */
+/*    This function returns TRUE if node a's next event comes before */
+/* node b's.  A node with nothing pending comes last.                */
+/*********************************************************************/
+int Tw_earlier(struct Tw_lp *a, struct Tw_lp *b)
+  {
+  if(a->pending.n == 0)
+         return(FALSE);
+  if(b->pending.n == 0)
+         return(TRUE);
+  return(Net_before(&a->pending.ev[0], &b->pending.ev[0]));
+  }
+
+/*********************************************************************/
+/* Name: Tw_resched                                                  */
+/* Description                                                       */
+/*    This procedure moves a node up or down its thread's heap after */
+/* its next event has changed.                                       */
+/*********************************************************************/
+void Tw_resched(struct Tw_thread *th, struct Tw_lp *lp)
+  {
+  struct Tw_lp *all = th->eng->lp;
+  int i = lp->slot, j;
+  while(i > 0 && Tw_earlier(lp, &all[th->sched[j = (i - 1) / 2]]))
+         {
+         th->sched[i] = th->sched[j];
+         all[th->sched[i]].slot = i;
+         i = j;
+         }
+  while((j = 2 * i + 1) < th->nsched)
+         {
+         if(j + 1 < th->nsched && Tw_earlier(&all[th->sched[j + 1]], &all[th->sched[j]]))
+                j++;
+         if(!Tw_earlier(&all[th->sched[j]], lp))
+                break;
+         th->sched[i] = th->sched[j];
+         all[th->sched[i]].slot = i;
+         i = j;
+         }
+  th->sched[i] = (int) (lp - all);
+  lp->slot = i;
+  }
+
+/*********************************************************************/
+/* Name: Tw_send                                                     */
+/* Description                                                       */
+/*    This procedure sends an arrival, or an anti-message for one,   */
+/* to the thread running its node.  A message to the thread itself   */
+/* goes on its delivery list; one to another thread is pushed onto   */
+/* that thread's inbox, a lock-free stack, with a release CAS, and   */
+/* counted under its color for the GVT round.  The message comes     */
+/* from the thread's spares, which only it touches, so malloc is     */
+/* called only while the number in flight still grows.               */
+/*********************************************************************/
+void Tw_send(struct Tw_thread *th, struct Net_event *ev, int anti)
+  {
+  struct Tw_thread *to = &th->eng->th[th->eng->owner[ev->node]];
+  struct Tw_msg *msg;
+  if((msg = th->spare) != NULL)
+         th->spare = msg->next;
+  else if((msg = (struct Tw_msg *) malloc(sizeof(struct Tw_msg))) == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  msg->anti = anti;
+  msg->color = th->round & 1;
+  msg->ev = *ev;
+  msg->next = NULL;
+  if(to == th)
+         {
+         if(th->tail == NULL)
+                th->head = msg;
+         else
+                th->tail->next = msg;
+         th->tail = msg;
+         return;
+         }
+  th->sent[msg->color]++;
+  if(ev->time < th->red_min)
+         th->red_min = ev->time;
+  msg->next = __atomic_load_n(&to->inbox, __ATOMIC_RELAXED);
+  while(!__atomic_compare_exchange_n(&to->inbox, &msg->next, msg, TRUE,
+                                     __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+         ;
+  }
+
+/*********************************************************************/
+/* Name: Tw_drain                                                    */
+/* Description                                                       */
+/*    This procedure takes everything in a thread's inbox, reversed  */
+/* so that each sender's messages keep their order, and delivers it  */
+/* along with anything the thread sent itself - including the        */
+/* anti-messages the deliveries lead to.  Delivered messages become  */
+/* the thread's spares.                                              */
+/*********************************************************************/
+void Tw_drain(struct Tw_thread *th)
+  {
+  struct Tw_msg *list, *msg, *first, *last;
+  list = __atomic_exchange_n(&th->inbox, NULL, __ATOMIC_ACQUIRE);
+  first = NULL;
+  last = list;
+  while(list != NULL)
+         {
+         msg = list;
+         list = msg->next;
+         msg->next = first;
+         first = msg;
+         __atomic_store_n(&th->received[msg->color], th->received[msg->color] + 1,
+                          __ATOMIC_RELEASE);
+         }
+  if(first != NULL)
+         {
+         if(th->tail == NULL)
+                th->head = first;
+         else
+                th->tail->next = first;
+         th->tail = last;
+         }
+  while((msg = th->head) != NULL)
+         {
+         th->head = msg->next;
+         if(th->head == NULL)
+                th->tail = NULL;
+         Tw_deliver(th, msg);
+         msg->next = th->spare;
+         th->spare = msg;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Tw_deliver                                                  */
+/* Description                                                       */
+/*    This procedure delivers a message to its node.  An arrival in  */
+/* the node's past first undoes the events after it.  An anti-message*/
+/* annihilates its arrival, undoing it first if it has been handled. */
+/* Messages from one sender arrive in order, so an arrival is always */
+/* there before its anti-message, and since every pending event of a */
+/* node comes after every event it has handled, the arrival is       */
+/* pending once the undoing is done.                                 */
+/*********************************************************************/
+void Tw_deliver(struct Tw_thread *th, struct Tw_msg *msg)
+  {
+  struct Tw_lp *lp = &th->eng->lp[msg->ev.node];
+  Tw_rollback(th, lp, &msg->ev);
+  if(!msg->anti)
+         Net_push(&lp->pending, &msg->ev);
+  else
+         Net_remove(&lp->pending, &msg->ev);
+  Tw_resched(th, lp);
+  }
+
+/*********************************************************************/
+/* Name: Tw_rollback                                                 */
+/* Description                                                       */
+/*    This procedure undoes, latest first, every uncommitted event   */
+/* of a node that does not come before ev.  Undoing an event takes   */
+/* back the events it scheduled, sends an anti-message for a job it  */
+/* sent on, reverses its change to the queue, restores the node's    */
+/* state and puts the event back on the pending list.  Since events  */
+/* are undone latest first the node's state is always as the event  */
+/* left it, so an arrival's job is still queued and a start's job is */
+/* the one in service.                                               */
+/*********************************************************************/
+void Tw_rollback(struct Tw_thread *th, struct Tw_lp *lp, struct Net_event *ev)
+  {
+  struct Tw_record *rec;
+  struct Net_node *nd = &lp->node;
+  int k, undone = FALSE;
+  while(lp->nlog > lp->first && !Net_before(&lp->log[lp->nlog - 1].ev, ev))
+         {
+         rec = &lp->log[--lp->nlog];
+         for(k = 0; k < rec->out.nlocal; k++)
+                Net_remove(&lp->pending, &rec->out.local[k]);
+         if(rec->out.dest == nd->index)
+                Net_remove(&lp->pending, &rec->out.msg);
+         else if(rec->out.dest >= 0)
+                {
+                Tw_send(th, &rec->out.msg, TRUE);
+                th->antis++;
+                }
+         if(rec->ev.type == NET_ARRIVE)
+                Netq_remove(&nd->queue, rec->ev.job.id, rec->ev.job.hop, rec->ev.time);
+         else if(rec->ev.type == NET_EXTERNAL)
+                Netq_remove(&nd->queue, ((unsigned long long) nd->index << 40) |
+                                        rec->saved.next_ext, 0, rec->ev.time);
+         else if(rec->ev.type == NET_START && nd->st.busy && !rec->saved.busy)
+                Netq_push(&nd->queue, &nd->st.serving);
+         nd->st = rec->saved;
+         Net_push(&lp->pending, &rec->ev);
+         th->undone++;
+         undone = TRUE;
+         }
+  if(undone)
+         th->rollbacks++;
+  }
+
+/*********************************************************************/
+/* Name: Tw_gvt                                                      */
+/* Description                                                       */
+/*    This function plays a thread's part in the GVT round, if one   */
+/* is under way, and returns the latest GVT.  Nobody blocks: rounds  */
+/* follow Mattern's two colors.  Each thread joins a round the next  */
+/* time it looks, and from then on its messages take the new color   */
+/* and it keeps the earliest time it sends.  Once all have joined    */
+/* and every message of the old color has been received, no message  */
+/* is unaccounted for, so each thread reports the earlier of its     */
+/* earliest pending event and its earliest message since joining,    */
+/* and the least report is the GVT.  A thread that has used up its   */
+/* share of events starts a round, or waits for the one under way,   */
+/* and gets a new share when it ends - which keeps the threads about */
+/* as close together as meeting every TW_BATCH events did, without   */
+/* any of them stopping the rest.  Only the round's bookkeeping is   */
+/* under the lock; the phase, round and GVT are read without it.     */
+/*********************************************************************/
+long int Tw_gvt(struct Tw_thread *th)
+  {
+  struct Tw_engine *eng = th->eng;
+  struct Tw_lp *top;
+  unsigned long long sent, received;
+  long int local;
+  int round, phase, old, w;
+  round = __atomic_load_n(&eng->round, __ATOMIC_ACQUIRE);
+  if(round != th->round)
+         {
+         /* join the round, turning to the new color */
+         pthread_mutex_lock(&eng->gvt_lock);
+         th->round = round;
+         th->red_min = MAXLONG;
+         __atomic_store_n(&eng->joined, eng->joined + 1, __ATOMIC_RELAXED);
+         pthread_mutex_unlock(&eng->gvt_lock);
+         }
+  phase = __atomic_load_n(&eng->phase, __ATOMIC_ACQUIRE);
+  if(phase == TW_JOIN && __atomic_load_n(&eng->joined, __ATOMIC_RELAXED) == eng->nthread)
+         {
+         /* all have joined: have the old color's messages all arrived? */
+         old = (round - 1) & 1;
+         pthread_mutex_lock(&eng->gvt_lock);
+         if(eng->phase == TW_JOIN && eng->round == round)
+                {
+                sent = received = 0;
+                for(w = 0; w < eng->nthread; w++)
+                       {
+                       sent += eng->th[w].sent[old];
+                       received += __atomic_load_n(&eng->th[w].received[old], __ATOMIC_ACQUIRE);
+                       }
+                if(sent == received)
+                       __atomic_store_n(&eng->phase, TW_REPORT, __ATOMIC_RELEASE);
+                }
+         pthread_mutex_unlock(&eng->gvt_lock);
+         }
+  else if(phase == TW_REPORT && th->reported != round)
+         {
+         /* deliver what has come in, then report */
+         Tw_drain(th);
+         local = th->red_min;
+         top = &eng->lp[th->sched[0]];
+         if(top->pending.n > 0 && top->pending.ev[0].time < local)
+                local = top->pending.ev[0].time;
+         th->reported = round;
+         pthread_mutex_lock(&eng->gvt_lock);
+         if(local < eng->round_min)
+                eng->round_min = local;
+         if(++eng->reported == eng->nthread)
+                {
+                __atomic_store_n(&eng->gvt, eng->round_min, __ATOMIC_RELEASE);
+                __atomic_store_n(&eng->phase, TW_IDLE, __ATOMIC_RELEASE);
+                __atomic_store_n(&eng->finished, round, __ATOMIC_RELEASE);
+                }
+         pthread_mutex_unlock(&eng->gvt_lock);
+         }
+  if(th->batch >= TW_BATCH && th->wait == 0)
+         {
+         /* out of events: start the next round, or wait for this one */
+         pthread_mutex_lock(&eng->gvt_lock);
+         if(eng->phase == TW_IDLE && eng->gvt < eng->parms->sim_length)
+                {
+                __atomic_store_n(&eng->joined, 0, __ATOMIC_RELAXED);
+                eng->reported = 0;
+                eng->round_min = MAXLONG;
+                __atomic_store_n(&eng->phase, TW_JOIN, __ATOMIC_RELEASE);
+                __atomic_store_n(&eng->round, eng->round + 1, __ATOMIC_RELEASE);
+                }
+         th->wait = eng->round;
+         pthread_mutex_unlock(&eng->gvt_lock);
+         }
+  else if(th->wait > 0 && __atomic_load_n(&eng->finished, __ATOMIC_ACQUIRE) >= th->wait)
+         {
+         /* the round is over: a new share of events */
+         th->batch = 0;
+         th->wait = 0;
+         }
+  return(__atomic_load_n(&eng->gvt, __ATOMIC_ACQUIRE));
+  }
+
+/*********************************************************************/
+/* Name: Tw_fossil                                                   */
+/* Description                                                       */
+/*    This procedure commits the records of a thread's nodes before  */
+/* the GVT, which can no longer be undone: the network times of the  */
+/* jobs they saw leave are recorded, and their space is reused.      */
+/*********************************************************************/
+void Tw_fossil(struct Tw_thread *th, long int gvt)
+  {
+  struct Tw_lp *lp;
+  long int k;
+  int i;
+  for(i = th->lo; i < th->hi; i++)
+         {
+         lp = &th->eng->lp[i];
+         for(k = lp->first; k < lp->nlog && lp->log[k].ev.time < gvt; k++)
+                if(lp->log[k].out.resp >= 0)
+                       Hdr_record(&lp->node.resp_hist, lp->log[k].out.resp);
+         lp->first = k;
+         if(lp->first == lp->nlog)
+                lp->first = lp->nlog = 0;
+         else if(lp->first > lp->nlog / 2)
+                {
+                memmove(lp->log, lp->log + lp->first,
+                        (lp->nlog - lp->first) * sizeof(struct Tw_record));
+                lp->nlog -= lp->first;
+                lp->first = 0;
+                }
+         }
+  }
+
+/*********************************************************************/
+/* Name: Pool_size                                                   */
+/* Description                                                       */
+/*    This function returns the number of threads to use for jobs    */
+/* pieces of work: the number asked for, or one per processor if     */
+/* that is 0, but never more threads than jobs.                      */
+/*********************************************************************/
+int Pool_size(int threads, long int jobs)
+  {
+  if(threads <= 0)
+         threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads <= 0)
+         threads = 1;
+  if(threads > jobs)
+         threads = (int) jobs;
+  return(threads);
+  }
+
+/*********************************************************************/
+/* Name: Numa_topology                                               */
+/* Description                                                       */
+/*    This function reads which processors belong to which NUMA node */
+/* from /sys/devices/system/node, keeping only those the process may */
+/* run on.  Without that directory every processor is taken to be on */
+/* one node.  It returns NULL if memory runs out.                    */
+/*********************************************************************/
+struct Numa_topo *Numa_topology(void)
+  {
+  struct Numa_topo *topo;
+  cpu_set_t allowed;
+  FILE *fp;
+  char fname[LINE_LEN], list[4096], *tok;
+  int n, k, c, lo, hi, *cpu;
+  topo = (struct Numa_topo *) calloc(1, sizeof(struct Numa_topo));
+  if(topo == NULL)
+         return(NULL);
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+         {
+         CPU_ZERO(&allowed);
+         for(c = 0; c < sysconf(_SC_NPROCESSORS_ONLN) && c < CPU_SETSIZE; c++)
+                CPU_SET(c, &allowed);
+         }
+  /* node numbers may have gaps, so look for every one */
+  for(n = 0; n < NUMA_MAX_NODES; n++)
+         {
+         sprintf(fname, "/sys/devices/system/node/node%d/cpulist", n);
+         if((fp = fopen(fname, "r")) == NULL)
+                continue;
+         if(fgets(list, sizeof(list), fp) == NULL)
+                list[0] = '\0';
+         fclose(fp);
+         cpu = (int *) malloc(CPU_SETSIZE * sizeof(int));
+         if(cpu == NULL)
+                {
+                Numa_free(topo);
+                return(NULL);
+                }
+         k = 0;
+         /* the list is ranges such as 0-7,16-23 */
+         for(tok = strtok(list, ",\n"); tok != NULL; tok = strtok(NULL, ",\n"))
+                {
+                if(sscanf(tok, "%d-%d", &lo, &hi) < 2)
+                       hi = lo;
+                for(c = lo; c <= hi && c < CPU_SETSIZE; c++)
+                       if(CPU_ISSET(c, &allowed))
+                              cpu[k++] = c;
+                }
+         if(k == 0)
+                {
+                free(cpu);
+                continue;
+                }
+         topo->id[topo->nnode] = n;
+         topo->ncpu[topo->nnode] = k;
+         topo->cpu[topo->nnode++] = cpu;
+         }
+  if(topo->nnode == 0)
+         {
+         printf(" ***Warning - no NUMA nodes found, taking every processor as one node***\n");
+         cpu = (int *) malloc(CPU_SETSIZE * sizeof(int));
+         if(cpu == NULL)
+                {
+                Numa_free(topo);
+                return(NULL);
+                }
+         k = 0;
+         for(c = 0; c < CPU_SETSIZE; c++)
+                if(CPU_ISSET(c, &allowed))
+                       cpu[k++] = c;
+         topo->id[0] = 0;
+         topo->ncpu[0] = k;
+         topo->cpu[0] = cpu;
+         topo->nnode = 1;
+         }
+  return(topo);
+  }
+
+/*********************************************************************/
+/* Name: Numa_free                                                   */
+/* Description                                                       */
+/*    This procedure frees a topology made by Numa_topology.         */
+/*********************************************************************/
+void Numa_free(struct Numa_topo *topo)
+  {
+  int n;
+  if(topo == NULL)
+         return;
+  for(n = 0; n < topo->nnode; n++)
+         free(topo->cpu[n]);
+  free(topo);
+  }
+
+/*********************************************************************/
+/* Name: Place_worker                                                */
+/* Description                                                       */
+/*    This function returns the processor worker w is pinned to and  */
+/* sets node to the index of its NUMA node in topo.  Compact fills   */
+/* each node's processors before using the next node, keeping the    */
+/* threads close; spread deals the workers across the nodes in turn, */
+/* giving each its share of the memory bandwidth.  Workers wrap      */
+/* around once every processor has one.                              */
+/*********************************************************************/
+int Place_worker(struct Numa_topo *topo, int policy, int w, int *node)
+  {
+  int n, k, total;
+  if(policy == PLACE_SPREAD)
+         {
+         n = w % topo->nnode;
+         *node = n;
+         return(topo->cpu[n][(w / topo->nnode) % topo->ncpu[n]]);
+         }
+  total = 0;
+  for(n = 0; n < topo->nnode; n++)
+         total += topo->ncpu[n];
+  k = w % total;
+  for(n = 0; k >= topo->ncpu[n]; n++)
+         k -= topo->ncpu[n];
+  *node = n;
+  return(topo->cpu[n][k]);
+  }
+
+/*********************************************************************/
+/* Name: Pin_thread                                                  */
+/* Description                                                       */
+/*    This function pins the calling thread to one processor,        */
+/* returning FALSE if it cannot.                                     */
+/*********************************************************************/
+int Pin_thread(int cpu)
+  {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return(sched_setaffinity(0, sizeof(set), &set) == 0);
+  }
+
+/*********************************************************************/
+/* Name: Npool_create                                                */
+/* Description                                                       */
+/*    This function makes an empty node pool.  It should be called   */
+/* by the thread that will use the pool, after it has been pinned.   */
+/*********************************************************************/
+struct Node_pool *Npool_create(void)
+  {
+  return((struct Node_pool *) calloc(1, sizeof(struct Node_pool)));
+  }
+
+/*********************************************************************/
+/* Name: Npool_get                                                   */
+/* Description                                                       */
+/*    This function returns a record of the given kind and size: a   */
+/* freed one if there is one, else a new one cut from the current    */
+/* slab.  A slab is mapped fresh, so its pages are first touched by  */
+/* the pool's thread; a record bigger than a slab gets a slab of its */
+/* own.  Each slab starts with a header linking it to the others and */
+/* giving its size.  With no pool it is malloc.  It returns NULL if  */
+/* memory runs out.                                                  */
+/*********************************************************************/
+void *Npool_get(struct Node_pool *pool, int kind, size_t size)
+  {
+  void *rec;
+  char *slab;
+  size_t bytes, head = 2 * sizeof(size_t);
+  if(pool == NULL)
+         return(malloc(size));
+  if((rec = pool->free[kind]) != NULL)
+         {
+         pool->free[kind] = *(void **) rec;
+         return(rec);
+         }
+  size = (size + 15) & ~(size_t) 15;
+  if(pool->slab == NULL || pool->used + size > POOL_SLAB)
+         {
+         bytes = (head + size > POOL_SLAB) ? head + size : POOL_SLAB;
+         slab = (char *) mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+         if(slab == MAP_FAILED)
+                return(NULL);
+         ((size_t *) slab)[0] = (size_t) pool->slabs;
+         ((size_t *) slab)[1] = bytes;
+         pool->slabs = slab;
+         if(bytes > POOL_SLAB)
+                return(slab + head);
+         pool->slab = slab;
+         pool->used = head;
+         }
+  rec = pool->slab + pool->used;
+  pool->used += size;
+  return(rec);
+  }
+
+/*********************************************************************/
+/* Name: Npool_put                                                   */
+/* Description                                                       */
+/*    This procedure gives a record back to its pool for reuse, or   */
+/* frees it if there is no pool.                                     */
+/*********************************************************************/
+void Npool_put(struct Node_pool *pool, int kind, void *rec)
+  {
+  if(pool == NULL)
+         {
+         free(rec);
+         return;
+         }
+  *(void **) rec = pool->free[kind];
+  pool->free[kind] = rec;
+  }
+
+/*********************************************************************/
+/* Name: Npool_destroy                                               */
+/* Description                                                       */
+/*    This procedure unmaps every slab of a pool and frees the pool. */
+/*********************************************************************/
+void Npool_destroy(struct Node_pool *pool)
+  {
+  char *slab, *next;
+  if(pool == NULL)
+         return;
+  for(slab = pool->slabs; slab != NULL; slab = next)
+         {
+         next = (char *) ((size_t *) slab)[0];
+         munmap(slab, ((size_t *) slab)[1]);
+         }
+  free(pool);
+  }
+
+/*********************************************************************/
+/* Name: Run_sweep                                                   */
+/* Description                                                       */
+/*    This procedure runs every point of the sweep on a pool of      */
+/* threads.  The points are dealt out to the workers in contiguous   */
+/* blocks, and a worker whose block is used up steals points from    */
+/* the back of the others' blocks, so a block of slow near-saturation*/
+/* points does not leave the other processors idle.  Each point has  */
+/* its own seed.  Lines are written in point order as soon as every  */
+/* point before them is done, so the results are the same whatever   */
+/* the number of threads.  Each point is also noted as it finishes,  */
+/* on stderr when the results go to stdout and on stdout otherwise,  */
+/* so a long sweep can be watched while points wait their turn.      */
+/*********************************************************************/
+void Run_sweep(struct Sim_parms *parms, int threads)
+  {
+  struct Sweep_worker *work;
+  struct Sweep_deque *deque;
+  pthread_mutex_t out_lock;
+  struct timespec start, end;
+  struct Sweep_result *res;
+  FILE *out;
+  double *point, elapsed;
+  long int npoint, done, steals, next_out;
+  char *ready;
+  int w;
+  point = Sweep_points(parms, &npoint);
+  out = Sweep_open(parms);
+  threads = Pool_size(threads, npoint);
+  work = (struct Sweep_worker *) malloc(threads * sizeof(struct Sweep_worker));
+  deque = (struct Sweep_deque *) malloc(threads * sizeof(struct Sweep_deque));
+  res = (struct Sweep_result *) malloc(npoint * sizeof(struct Sweep_result));
+  ready = (char *) calloc(npoint, sizeof(char));
+  if(work == NULL || deque == NULL || res == NULL || ready == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  printf(" Sweeping %ld points on %d threads\n", npoint, threads);
+  fflush(stdout);
+  next_out = 0;
+  pthread_mutex_init(&out_lock, NULL);
+  for(w = 0; w < threads; w++)
+         {
+         pthread_mutex_init(&deque[w].lock, NULL);
+         deque[w].front = w * npoint / threads;
+         deque[w].back = (w + 1) * npoint / threads;
+         }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(w = 0; w < threads; w++)
+         {
+         work[w].parms = parms;
+         work[w].index = w;
+         work[w].nworker = threads;
+         work[w].deque = deque;
+         work[w].point = point;
+         work[w].npoint = npoint;
+         work[w].out = out;
+         work[w].progress = (out == stdout) ? stderr : stdout;
+         work[w].out_lock = &out_lock;
+         work[w].res = res;
+         work[w].ready = ready;
+         work[w].next_out = &next_out;
+         work[w].done = 0;
+         work[w].steals = 0;
+         if(pthread_create(&work[w].thread, NULL, Sweep_worker, &work[w]) != 0)
+                {
+                printf(" ***Error - cannot start sweep thread %d***\n", w);
+                exit(1);
+                }
+         }
+  done = 0;
+  steals = 0;
+  for(w = 0; w < threads; w++)
+         {
+         pthread_join(work[w].thread, NULL);
+         done += work[w].done;
+         steals += work[w].steals;
+         }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  /* any worker may steal from any deque until the last one ends */
+  for(w = 0; w < threads; w++)
+         pthread_mutex_destroy(&deque[w].lock);
+  pthread_mutex_destroy(&out_lock);
+  if(out != stdout)
+         fclose(out);
+  printf("...Sweep ends\n");
+  printf(" points run / stolen --------> %ld / %ld\n", done, steals);
+  printf(" wall time / points/s -------> %.3f / %.1f\n", elapsed,
+         elapsed > 0 ? done / elapsed : 0);
+  if(point != parms->sweep->point)
+         free(point);
+  free(work);
+  free(deque);
+  free(res);
+  free(ready);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_points                                                */
+/* Description                                                       */
+/*    This function returns the iarrive, service and seed of every   */
+/* sweep point and sets npoint.  A list is returned as it is; a grid */
+/* is expanded into a new array, seed varying fastest, then service, */
+/* then iarrive.  Grid axes the sweep file leaves out take the value */
+/* typed in.                                                         */
+/*********************************************************************/
+double *Sweep_points(struct Sim_parms *parms, long int *npoint)
+  {
+  struct Sweep *sw = parms->sweep;
+  double *point, given[3];
+  long int k, rem;
+  int a, n;
+  if(!sw->grid)
+         {
+         *npoint = sw->npoint;
+         return(sw->point);
+         }
+  given[0] = parms->iarrive_time;
+  given[1] = parms->service_time;
+  given[2] = parms->seed;
+  *npoint = 1;
+  for(a = 0; a < 3; a++)
+         *npoint *= (sw->naxis[a] > 0) ? sw->naxis[a] : 1;
+  point = (double *) malloc(3 * *npoint * sizeof(double));
+  for(k = 0; k < *npoint; k++)
+         {
+         rem = k;
+         for(a = 2; a >= 0; a--)
+                {
+                n = (sw->naxis[a] > 0) ? sw->naxis[a] : 1;
+                point[3*k + a] = (sw->naxis[a] > 0) ? sw->axis[a][rem % n] : given[a];
+                rem /= n;
+                }
+         }
+  return(point);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_open                                                  */
+/* Description                                                       */
+/*    This function opens the sweep results file, stdout if none was */
+/* given, and writes the column heading.                             */
+/*********************************************************************/
+FILE *Sweep_open(struct Sim_parms *parms)
+  {
+  FILE *out;
+  int i;
+  if(parms->sweep_out == NULL)
+         out = stdout;
+  else if((out = fopen(parms->sweep_out, "w")) == NULL)
+         {
+         printf(" ***Error - cannot open sweep output %s***\n", parms->sweep_out);
+         exit(1);
+         }
+  fprintf(out, "# point iarrive service seed utilization customers mean_resp ci_half");
+  for(i = 0; i < parms->num_pct; i++)
+         fprintf(out, " p%g", parms->pct_list[i]);
+  fprintf(out, " analytic\n");
+  fflush(out);
+  return(out);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_worker                                                */
+/* Description                                                       */
+/*    This function is the body of one sweep thread.  It runs points */
+/* until no worker has any left.  No points are added once the sweep */
+/* starts, so one pass that finds every deque empty means the end.   */
+/*********************************************************************/
+void *Sweep_worker(void *arg)
+  {
+  struct Sweep_worker *work = (struct Sweep_worker *) arg;
+  long int k;
+  while((k = Sweep_next(work)) >= 0)
+         {
+         Sweep_point(work, k);
+         work->done++;
+         }
+  return(NULL);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_next                                                  */
+/* Description                                                       */
+/*    This function returns the next point for a worker to run: the  */
+/* front of its own deque, or else the back of the first other deque */
+/* that is not empty.  It returns -1 when every deque is empty.      */
+/*********************************************************************/
+long int Sweep_next(struct Sweep_worker *work)
+  {
+  struct Sweep_deque *dq;
+  long int k;
+  int i;
+  dq = &work->deque[work->index];
+  k = -1;
+  pthread_mutex_lock(&dq->lock);
+  if(dq->front < dq->back)
+         k = dq->front++;
+  pthread_mutex_unlock(&dq->lock);
+  for(i = 1; k < 0 && i < work->nworker; i++)
+         {
+         dq = &work->deque[(work->index + i) % work->nworker];
+         pthread_mutex_lock(&dq->lock);
+         if(dq->front < dq->back)
+                {
+                k = --dq->back;
+                work->steals++;
+                }
+         pthread_mutex_unlock(&dq->lock);
+         }
+  return(k);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_point                                                 */
+/* Description                                                       */
+/*    This procedure runs sweep point k in its own context, notes    */
+/* that it is done, then writes the results of every point from the  */
+/* first one not yet written up to the first one not yet done.       */
+/*********************************************************************/
+void Sweep_point(struct Sweep_worker *work, long int k)
+  {
+  struct Sweep_result res;
+  long int *next = work->next_out;
+  if(!Sweep_run_point(work->parms, work->point, k, &res, NULL))
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  pthread_mutex_lock(work->out_lock);
+  work->res[k] = res;
+  work->ready[k] = TRUE;
+  fprintf(work->progress, " point %ld done\n", k);
+  fflush(work->progress);
+  while(*next < work->npoint && work->ready[*next])
+         {
+         Sweep_write(work->out, work->parms, work->point, *next, &work->res[*next]);
+         (*next)++;
+         }
+  fflush(work->out);
+  pthread_mutex_unlock(work->out_lock);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_run_point                                             */
+/* Description                                                       */
+/*    This procedure runs sweep point k and fills in its results:    */
+/* measured utilization, customers served, mean response time with   */
+/* its batch means CI half-width, the requested percentiles and the  */
+/* analytic mean.  If hist is not NULL the response time histogram   */
+/* is copied to it.  It returns FALSE if memory runs out, leaving the */
+/* caller to report it: a worker process must not exit through the   */
+/* stdio buffers it shares with its parent.                          */
+/*********************************************************************/
+int Sweep_run_point(struct Sim_parms *base, double *point, long int k,
+                    struct Sweep_result *res, struct Hdr_hist *hist)
+  {
+  struct Sim_parms parms;
+  struct Sim_context *sim;
+  double corr;
+  int i;
+  parms = *base;
+  parms.iarrive_time = point[3*k];
+  parms.service_time = point[3*k + 1];
+  parms.seed = (unsigned) point[3*k + 2];
+  sim = Sim_create(&parms, 0, FALSE);
+  if(sim == NULL)
+         return(FALSE);
+  Sim_run(sim);
+  res->half = Batch_ci(&sim->resp_batch, Warmup_batches(sim), &res->mean, &corr) / 100;
+  res->util = sim->clock > 0 ? sim->tavg.busy / sim->clock : 0;
+  res->customers = sim->resp_stat.count;
+  res->mean = Stat_mean(&sim->resp_stat) / 100;
+  for(i = 0; i < parms.num_pct; i++)
+         res->pct[i] = Hdr_percentile(&sim->resp_hist, parms.pct_list[i]) / 100;
+  res->analytic = Analytic_sjf(&parms);
+  if(hist != NULL)
+         memcpy(hist, &sim->resp_hist, sizeof(struct Hdr_hist));
+  Sim_destroy(sim);
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Sweep_write                                                 */
+/* Description                                                       */
+/*    This procedure writes the results line of sweep point k.       */
+/*********************************************************************/
+void Sweep_write(FILE *out, struct Sim_parms *parms, double *point, long int k,
+                 struct Sweep_result *res)
+  {
+  int i;
+  fprintf(out, "%ld %g %g %u %.4f %llu %.3f %.3f", k, (float) point[3*k],
+          (float) point[3*k + 1], (unsigned) point[3*k + 2], res->util, res->customers,
+          res->mean, res->half);
+  for(i = 0; i < parms->num_pct; i++)
+         fprintf(out, " %.3f", res->pct[i]);
+  if(res->analytic < 0)
+         fprintf(out, " -\n");
+  else if(res->analytic == MAXDOUBLE)
+         fprintf(out, " inf\n");
+  else
+         fprintf(out, " %.3f\n", res->analytic);
+  }
+
+
+/*********************************************************************/
+/* Name: Insert_event                                                   */
+/* Description                                                          */
+/*    This procedure will insert the simulation event into a doubly     */
+/*    linked queue.  The parameters are as follows:                     */
+/*     etype - type of event to be inserted.                            */
+/*     etime - the time the event will occur.                        */
+/*     custind - index of the customer associated with this event.      */
+/* The following steps are performed:                                   */
+/*     1 - get a free node and add the event information.               */
+/*     2 - insert node into the proper place in the queue.              */
+/*         2a - into an empty queue.                                    */
+/*         2b - at the top of the queue.                                */
+/*         2c - at the bottom of the queue.                             */
+/*         2d - regular insertion (someplace in the middle).            */
+/*********************************************************************/
+void Insert_event(struct Sim_context *sim, int etype, long int etime,struct Custs *custind)
+  {
+  int not_found;
+  struct event_node *loc, *pos;
+  loc = (struct event_node *) Npool_get(sim->pool, POOL_EVENT, sizeof(struct event_node));
+ /* add the information to the structure */
+  loc->ev_type = etype;
+  loc->ev_time = etime;
+  loc->cust_index = custind;
+  loc->forward = NULL;
+  loc->backward = NULL;
+ /* determine if the list is empty */
+  if(sim->top_event == NULL)
+         {
+         sim->top_event = loc;
+         sim->last_event = loc;
+         return;
+         }
+  /* see if it belongs on top */
+   if(sim->top_event->ev_time > etime)
+         {
+         sim->top_event->backward = loc;
+         loc->forward = sim->top_event;
+         sim->top_event = loc;
+         return;
+         }
+ /* see if it belongs at the bottom */
+  if(sim->last_event->ev_time <= etime)
+         {
+         sim->last_event->forward = loc;
+         loc->backward = sim->last_event;
+         sim->last_event = loc;
+         return;
+         }
+ /* it belongs somewhere in the middle so find its place */
+  not_found = TRUE;
+  pos = sim->top_event;
+  while(pos != NULL && not_found)
+         {
+        if(pos->ev_time > etime)
+                not_found = FALSE;
+         else
+                pos = pos->forward;
+         }
+  /* check to see if we found something as we should have */
+  if(not_found)
+         {
+         printf(" ***Error - problems in insert event routine***\n");
+         return;
+         }
+  /* add node to appropriate place */
+  loc->forward = pos;
+  loc->backward = pos->backward;
+  (pos->backward)->forward = loc;
+  pos->backward = loc;
+  return;
+}
+
+/*********************************************************************/
+/* Name: Remove_event                                           */
+/* Description                                                  */
+/*    This function returns the next event from the head of the */
+/* event list.  It checks for a special case where there is only        */
+/* one event so the event list can be marked empty.                     */
+/*********************************************************************/
+struct event_node *Remove_event(struct Sim_context *sim)
+  {
+  struct event_node *ev_ptr;
+  /* check to see if event list is empty */
+  if(sim->last_event == NULL)
+         {
+         printf(" ***Error - Event list underflow***\n");
+         return(NULL);
+         }
+  /* remove top element */
+  ev_ptr = sim->top_event;
+  /* see if it was the only event - special case to mark empty */
+  if(sim->top_event == sim->last_event)
+         {
+         sim->top_event = NULL;
+         sim->last_event = NULL;
+         return(ev_ptr);
+         }
+  /* event list has more than one element so just relink */
+  sim->top_event = sim->top_event->forward;
+  sim->top_event->backward = NULL;
+  ev_ptr->forward = NULL;
+  return(ev_ptr);
+  }
+
+/*********************************************************************/
+/* Name: Puton_queue                                            */
+/* Description                                                          */
+/*    This procedure inserts a customer at the end of the given         */
+/* queue. The parameters are as follows:                        */
+/*     pqueue - pointer to the queue.                                   */
+/*     pcust - index of the customer to be inserted.                    */
+/* The procedure performs the following steps:                          */
+/*     1 - get a free node for the customer.                    */
+/*     2 - insert the node at the end of the queue.              */
+/*         2a - into an empty queue                             */
+/*         2b - normal insertion                                */
+/*********************************************************************/
+void Puton_queue(struct Queue_struct *pqueue, struct Custs *pcust)
+  {
+  struct Queue *newnode;
+  /* get an new node */
+  newnode = (struct Queue *) Npool_get(pqueue->pool, POOL_QUEUE, sizeof(struct Queue));
+  /* now loc is the index of a free node in queue */
+  /* put information in the node */
+  newnode->cust_index = pcust;
+  newnode->next = NULL;
+ /* check to see if the queue is initially empty */
+  if(pqueue->q_last == NULL)
+         {
+         /* if so, add to queue as head and last node */
+         pqueue->q_head = newnode;
+         pqueue->q_last = newnode;
+         return;
+         }
+
+  /* if newnode's burst time is less than the first node's in queue, add to beginning of queue - ADDED BY ME */
+  if(newnode->cust_index->CPU_time < pqueue->q_head->cust_index->CPU_time){
+      newnode->next = pqueue->q_head;
+      pqueue->q_head = newnode;
+      return;
+  }
+
+  /* if newnode's burst time is greater than the last node's in the queue, add to end of queue - ADDED BY ME */
+  if(newnode->cust_index->CPU_time >= pqueue->q_last->cust_index->CPU_time){
+      pqueue->q_last->next = newnode;
+      pqueue->q_last = newnode;
+      return;
+  }
+  /* create new Queue structures to represent the nodes which the new node will be inserted in between in the queue - ADDED BY ME */
+  struct Queue *previous_node;
+  struct Queue *following_node;
+  previous_node = pqueue->q_head;
+  following_node = pqueue->q_head->next;
+  bool searching = true;
+
+  /* traverse the queue and when there is a node in which the new node has a smaller CPU time than, insert the new node before that node in the queue - ADDED BY ME*/
+  do{
+      if(newnode->cust_index->CPU_time < following_node->cust_index->CPU_time){
+          newnode->next = previous_node->next;
+          previous_node->next = newnode;
+          return;
+      }
+      previous_node = previous_node->next;
+      following_node = following_node->next;
+  }while(searching);
+  }
+
+/*********************************************************************/
+/* Name: Takoff_queue                                                   */
+/* Description                                                          */
+/*    This function returns the index into the customer array of        */
+/* the head element of the given queue. The parameters are:             */
+/*     pqueue -  pointer to the given queue.                            */
+/* If the customer removed is the last remaining customer, the  */
+/* queue is marked empty.                                       */
+/*********************************************************************/
+struct Custs *Takoff_queue(struct Queue_struct *pqueue)
+  {
+  struct Queue *loc;
+  struct Custs *index;
+  /* check if the queue is empty */
+  if(pqueue->q_head == NULL)
+         {
+         printf(" ***Error - queue underflow***\n");
+         return(NULL);
+         }
+  /* remove top element from queue */
+  loc = pqueue->q_head;
+  /* get customer index */
+  index = loc->cust_index;
+ /* check if queue now empty and relink */
+  if(pqueue->q_head == pqueue->q_last)
+         {
+         pqueue->q_last = NULL;
+         pqueue->q_head = NULL;
+         Npool_put(pqueue->pool, POOL_QUEUE, loc);
+         return(index);
+         }
+  /* otherwise just relink */
+  pqueue->q_head = loc->next;
+  Npool_put(pqueue->pool, POOL_QUEUE, loc);
+  return(index);
+  }
+
+/*********************************************************************/
+/* Name: expon                                                          */
+/* Description                                                          */
+/*    This function is used to generate an exponential variate given */
+/* the mean time and a uniform random number u in (0,1).                */
+/*********************************************************************/
+long int expon(float time, double u)
+  {
+  long int val;
+  time = time * 100;
+  val = ceil(-time * log(u));
+  return(val);
+  }
+
+/*********************************************************************/
+/* Name: Uniform                                                     */
+/* Description                                                       */
+/*    This function returns a uniform random number in (0,1).  It is */
+/* a counter based generator: the seed, the stream, the customer     */
+/* number and the draw number (for variates that need more than one  */
+/* uniform) are hashed together, so each customer always gets the    */
+/* same numbers no matter when they are asked for.  The replication  */
+/* number selects an independent substream, and in antithetic runs   */
+/* 1-U is returned in place of U.                                    */
+/*********************************************************************/
+double Uniform(struct Sim_context *sim, int stream, unsigned long int cust, int draw)
+  {
+  return(Counter_uniform(sim->parms->seed, sim->replication, sim->antithetic,
+                         stream, cust, draw));
+  }
+
+/*********************************************************************/
+/* Name: Counter_uniform                                             */
+/* Description                                                       */
+/*    This function is the generator behind Uniform, with the seed,  */
+/* replication and antithetic flag passed in rather than taken from  */
+/* a context.  It has no state, so engines that run many             */
+/* replications side by side can call it for each of them.           */
+/*********************************************************************/
+double Counter_uniform(unsigned seed, unsigned long int replication, int antithetic,
+                       int stream, unsigned long int cust, int draw)
+  {
+  unsigned long long x;
+  double u;
+  x = ((unsigned long long) seed << 32) ^ ((unsigned long long) stream << 24)
+      ^ (unsigned long long) draw;
+  x = Mix64(Mix64(x) ^ replication) ^ (unsigned long long) cust;
+  x = Mix64(x);
+  /* top 52 bits, offset by half a step so 0 and 1 never appear */
+  u = ((x >> 12) + 0.5) * (1.0 / 4503599627370496.0);
+  if(antithetic)
+         return(1.0 - u);
+  return(u);
+  }
+
+/*********************************************************************/
+/* Name: Mix64                                                       */
+/* Description                                                       */
+/*    This function is the splitmix64 finalizer, a bijective 64 bit  */
+/* mixing function used to turn counters into random bits.           */
+/*********************************************************************/
+unsigned long long Mix64(unsigned long long x)
+  {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return(x ^ (x >> 31));
+  }
+
+/*********************************************************************/
+/* Name: Load_dist                                                   */
+/* Description                                                       */
+/*    This function loads an empirical distribution from a file.     */
+/* Blank lines and lines starting with # are ignored.  The format is */
+/* decided by the first data line:                                   */
+/*     "value weight" - a histogram, one bin per line.               */
+/*     "value"        - raw samples, one per line.                   */
+/* The file is read once into memory, so it may be a pipe.  Raw      */
+/* samples are then counted into EMP_BINS bins spaced evenly in      */
+/* log(value), so each is the same small fraction of its value and   */
+/* heavy tailed samples keep the short jobs apart; zeros, if any,    */
+/* get the first bin to themselves.  The mean is that of the bins,   */
+/* which is what is sampled.  Values use the same units as the mean  */
+/* service time.  Returns NULL if the file cannot be used.           */
+/*********************************************************************/
+struct Emp_dist *Load_dist(char *fname)
+  {
+  FILE *fp;
+  char line[LINE_LEN];
+  struct Emp_dist *dist;
+  double v, w, lo, pos, hi, ratio, sum, wsum, *weight, *val, *wt, *grown;
+  long int count, size, bin, k;
+  int nfields, first, i;
+  if((fp = fopen(fname, "r")) == NULL)
+         {
+         printf(" ***Error - cannot open distribution file %s***\n", fname);
+         return(NULL);
+         }
+  /* read every entry, deciding the format and finding the range */
+  nfields = 0;
+  count = 0;
+  size = 0;
+  val = NULL;
+  wt = NULL;
+  lo = MAXDOUBLE;
+  pos = MAXDOUBLE;
+  hi = -MAXDOUBLE;
+  while(fgets(line, LINE_LEN, fp) != NULL)
+         {
+         i = sscanf(line, "%lf %lf", &v, &w);
+         if(i < 1 || line[0] == '#')
+                continue;
+         if(nfields == 0)
+                nfields = i;
+         if(i < nfields)
+                continue;
+         if(v < 0)
+                {
+                printf(" ***Error - negative value in %s***\n", fname);
+                fclose(fp);
+                free(val);
+                free(wt);
+                return(NULL);
+                }
+         if(count == size)
+                {
+                size = (size == 0) ? 1024 : 2 * size;
+                grown = (double *) realloc(val, size * sizeof(double));
+                if(grown != NULL)
+                       val = grown;
+                if(grown != NULL && nfields == 2)
+                       {
+                       grown = (double *) realloc(wt, size * sizeof(double));
+                       if(grown != NULL)
+                              wt = grown;
+                       }
+                if(grown == NULL)
+                       {
+                       printf(" ***Error - out of memory reading %s***\n", fname);
+                       fclose(fp);
+                       free(val);
+                       free(wt);
+                       return(NULL);
+                       }
+                }
+         val[count] = v;
+         if(nfields == 2)
+                wt[count] = (w < 0) ? 0 : w;
+         if(v < lo) lo = v;
+         if(v > 0 && v < pos) pos = v;
+         if(v > hi) hi = v;
+         count++;
+         }
+  fclose(fp);
+  if(count == 0)
+         {
+         printf(" ***Error - no data in distribution file %s***\n", fname);
+         return(NULL);
+         }
+  dist = (struct Emp_dist *) calloc(1, sizeof(struct Emp_dist));
+  if(dist == NULL)
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         free(val);
+         free(wt);
+         return(NULL);
+         }
+  dist->raw = (nfields == 1);
+  sum = 0;
+  wsum = 0;
+  if(!dist->raw)
+         {
+         /* the entries are the bins, kept in increasing value */
+         dist->nbins = count;
+         dist->value = val;
+         weight = wt;
+         if(!Sort_bins(dist->value, weight, dist->nbins))
+                {
+                printf(" ***Error - out of memory reading %s***\n", fname);
+                Emp_free(dist);
+                free(weight);
+                return(NULL);
+                }
+         for(k = 0; k < count; k++)
+                {
+                sum += val[k] * weight[k];
+                wsum += weight[k];
+                }
+         if(wsum <= 0)
+                {
+                printf(" ***Error - histogram in %s has no weight***\n", fname);
+                Emp_free(dist);
+                free(weight);
+                return(NULL);
+                }
+         }
+  else
+         {
+         /* geometric edges from the smallest positive sample to the */
+         /* largest, after a bin holding only zeros when there are any */
+         dist->nbins = EMP_BINS;
+         weight = (double *) calloc(EMP_BINS, sizeof(double));
+         dist->left = (double *) malloc(EMP_BINS * sizeof(double));
+         dist->width = (double *) malloc(EMP_BINS * sizeof(double));
+         if(weight == NULL || dist->left == NULL || dist->width == NULL)
+                {
+                printf(" ***Error - out of memory reading %s***\n", fname);
+                Emp_free(dist);
+                free(weight);
+                free(val);
+                return(NULL);
+                }
+         first = (lo == 0 && hi > 0) ? 1 : 0;
+         if(hi == 0)
+                pos = 0;
+         ratio = (hi > pos) ? log(hi / pos) / (EMP_BINS - first) : 0;
+         dist->left[0] = 0;
+         dist->width[0] = 0;
+         for(i = first; i < EMP_BINS; i++)
+                {
+                dist->left[i] = pos * exp((i - first) * ratio);
+                dist->width[i] = ((i == EMP_BINS - 1) ? hi : pos * exp((i + 1 - first) * ratio))
+                                 - dist->left[i];
+                }
+         for(k = 0; k < count; k++)
+                {
+                v = val[k];
+                if(v == 0)
+                       bin = 0;
+                else if(ratio == 0)
+                       bin = first;
+                else
+                       bin = first + (long int) (log(v / pos) / ratio);
+                if(bin >= EMP_BINS)
+                       bin = EMP_BINS - 1;
+                weight[bin] += 1;
+                }
+         free(val);
+         for(i = 0; i < EMP_BINS; i++)
+                sum += weight[i] * (dist->left[i] + dist->width[i] / 2);
+         wsum = count;
+         }
+  dist->mean = sum / wsum;
+  if(!Build_alias(dist, weight))
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         Emp_free(dist);
+         free(weight);
+         return(NULL);
+         }
+  free(weight);
+  return(dist);
+  }
+
+/*********************************************************************/
+/* Name: Emp_free                                                    */
+/* Description                                                       */
+/*    This procedure frees an empirical distribution, including one  */
+/* only partly built.                                                */
+/*********************************************************************/
+void Emp_free(struct Emp_dist *dist)
+  {
+  free(dist->left);
+  free(dist->width);
+  free(dist->value);
+  free(dist->prob);
+  free(dist->alias);
+  free(dist);
+  }
+
+/*********************************************************************/
+/* Name: Sort_bins                                                   */
+/* Description                                                       */
+/*    This function sorts histogram bins into increasing value,      */
+/* keeping each weight with its value.  It returns FALSE if memory   */
+/* runs out.                                                         */
+/*********************************************************************/
+int Sort_bins(double *value, double *weight, int n)
+  {
+  struct Centroid *bins;
+  int i;
+  bins = (struct Centroid *) malloc(n * sizeof(struct Centroid));
+  if(bins == NULL)
+         return(FALSE);
+  for(i = 0; i < n; i++)
+         {
+         bins[i].mean = value[i];
+         bins[i].weight = weight[i];
+         }
+  qsort(bins, n, sizeof(struct Centroid), Centroid_cmp);
+  for(i = 0; i < n; i++)
+         {
+         value[i] = bins[i].mean;
+         weight[i] = bins[i].weight;
+         }
+  free(bins);
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Build_alias                                                 */
+/* Description                                                       */
+/*    This function builds the Walker alias table for the given bin  */
+/* weights (Vose's method).  Each bin is split into the part kept by */
+/* the bin and the part handed to its alias, so that a sample needs  */
+/* one table lookup however many bins there are.  It returns FALSE   */
+/* if memory runs out.                                               */
+/*********************************************************************/
+int Build_alias(struct Emp_dist *dist, double *weight)
+  {
+  int n, i, s, l, nsmall, nlarge;
+  int *small, *large;
+  double total;
+  n = dist->nbins;
+  dist->prob = (double *) malloc(n * sizeof(double));
+  dist->alias = (int *) malloc(n * sizeof(int));
+  small = (int *) malloc(n * sizeof(int));
+  large = (int *) malloc(n * sizeof(int));
+  if(dist->prob == NULL || dist->alias == NULL || small == NULL || large == NULL)
+         {
+         free(small);
+         free(large);
+         return(FALSE);
+         }
+  total = 0;
+  for(i = 0; i < n; i++)
+         total += weight[i];
+  /* scale weights so the average bin holds exactly 1 */
+  nsmall = 0;
+  nlarge = 0;
+  for(i = 0; i < n; i++)
+         {
+         dist->prob[i] = weight[i] * n / total;
+         dist->alias[i] = i;
+         if(dist->prob[i] < 1.0)
+                small[nsmall++] = i;
+         else
+                large[nlarge++] = i;
+         }
+  /* fill each small bin up to 1 from a large bin */
+  while(nsmall > 0 && nlarge > 0)
+         {
+         s = small[--nsmall];
+         l = large[nlarge - 1];
+         dist->alias[s] = l;
+         dist->prob[l] -= 1.0 - dist->prob[s];
+         if(dist->prob[l] < 1.0)
+                {
+                nlarge--;
+                small[nsmall++] = l;
+                }
+         }
+  /* whatever is left is full up to rounding error */
+  while(nlarge > 0)
+         dist->prob[large[--nlarge]] = 1.0;
+  while(nsmall > 0)
+         dist->prob[small[--nsmall]] = 1.0;
+  free(small);
+  free(large);
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Emp_sample                                                  */
+/* Description                                                       */
+/*    This function draws a service time from an empirical           */
+/* distribution.  A bin is picked from the alias table and, for      */
+/* tables built from raw samples, a point is picked uniformly inside */
+/* the bin.  The result is scaled by 100 like expon.  The uniforms   */
+/* come from the service stream of customer cust.                    */
+/*********************************************************************/
+long int Emp_sample(struct Sim_context *sim, struct Emp_dist *dist, unsigned long int cust)
+  {
+  double v;
+  v = dist->raw ? Uniform(sim, SERVICE_STREAM, cust, 1) : 0;
+  return(Emp_draw(dist, Uniform(sim, SERVICE_STREAM, cust, 0), v));
+  }
+
+/*********************************************************************/
+/* Name: Emp_draw                                                    */
+/* Description                                                       */
+/*    This function turns uniforms into a sample of the empirical    */
+/* distribution: u picks the alias table column and v, used only for */
+/* tables built from raw samples, the position within the bin.       */
+/*********************************************************************/
+long int Emp_draw(struct Emp_dist *dist, double u, double v)
+  {
+  int bin;
+  double val;
+  /* pick a column of the table, the fraction left decides the alias */
+  u = u * dist->nbins;
+  bin = (int) u;
+  if(u - bin >= dist->prob[bin])
+         bin = dist->alias[bin];
+  if(dist->raw)
+         val = dist->left[bin] + v * dist->width[bin];
+  else
+         val = dist->value[bin];
+  return((long int) ceil(val * 100));
+  }
+
+/*********************************************************************/
+/* Name: Normal_quantile                                             */
+/* Description                                                       */
+/*    This function returns the p quantile of the standard normal    */
+/* distribution, using Acklam's rational approximation (relative     */
+/* error below 1.2e-9).                                              */
+/*********************************************************************/
+double Normal_quantile(double p)
+  {
+  static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+         -2.759285104469687e+02, 1.383577518672690e+02,
+         -3.066479806614716e+01, 2.506628277459239e+00};
+  static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+         -1.556989798598866e+02, 6.680131188771972e+01,
+         -1.328068155288572e+01};
+  static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+         -2.400758277161838e+00, -2.549732539343734e+00,
+         4.374664141464968e+00, 2.938163982698783e+00};
+  static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+         2.445134137142996e+00, 3.754408661907416e+00};
+  double q, r;
+  if(p <= 0)
+         return(-MAXDOUBLE);
+  if(p >= 1)
+         return(MAXDOUBLE);
+  /* lower tail */
+  if(p < 0.02425)
+         {
+         q = sqrt(-2 * log(p));
+         return((((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1));
+         }
+  /* upper tail */
+  if(p > 1 - 0.02425)
+         {
+         q = sqrt(-2 * log(1 - p));
+         return(-(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1));
+         }
+  /* central region */
+  q = p - 0.5;
+  r = q * q;
+  return((((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+         (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1));
+  }
+
+/*********************************************************************/
+/* Name: T_quantile                                                  */
+/* Description                                                       */
+/*    This function returns the p quantile of Student's t            */
+/* distribution with df degrees of freedom, from the normal quantile */
+/* by the Cornish-Fisher expansion.  It is good to about 1% for      */
+/* df >= 3, which is plenty for confidence interval half-widths.     */
+/*********************************************************************/
+double T_quantile(double p, long int df)
+  {
+  double z, z2, n;
+  z = Normal_quantile(p);
+  if(df < 1)
+         return(z);
+  /* the expansion is poor with one or two degrees of freedom */
+  if(df == 1)
+         return(tan(M_PI * (p - 0.5)));
+  if(df == 2)
+         return((2 * p - 1) * sqrt(2 / (4 * p * (1 - p))));
+  z2 = z * z;
+  n = (double) df;
+  return(z + z * (z2 + 1) / (4 * n)
+           + z * ((5 * z2 + 16) * z2 + 3) / (96 * n * n)
+           + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * n * n * n));
+  }
+
+/*********************************************************************/
+/* Name: Load_profile                                                */
+/* Description                                                       */
+/*    This function loads an arrival rate profile.  Blank lines and  */
+/* lines starting with # are ignored.  The first word is "constant"  */
+/* or "linear", followed by "time rate" lines with increasing times  */
+/* starting at 0.  The last time is the period, after which the      */
+/* profile repeats; its rate is only used by linear profiles, so the */
+/* last line of a constant profile may give the time alone.  Times   */
+/* use the units of the mean interarrival time and rates are         */
+/* arrivals per time unit.  Internally everything is kept in clock   */
+/* ticks.  Returns NULL if the file cannot be used.                  */
+/*********************************************************************/
+struct Rate_profile *Load_profile(char *fname)
+  {
+  FILE *fp;
+  char line[LINE_LEN], word[LINE_LEN];
+  struct Rate_profile *prof;
+  double t, r, area, *grown;
+  int n, size, i, fields, ended, nomem;
+  if((fp = fopen(fname, "r")) == NULL)
+         {
+         printf(" ***Error - cannot open rate profile %s***\n", fname);
+         return(NULL);
+         }
+  prof = (struct Rate_profile *) calloc(1, sizeof(struct Rate_profile));
+  if(prof == NULL)
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         fclose(fp);
+         return(NULL);
+         }
+  prof->linear = -1;
+  size = 16;
+  prof->start = (double *) malloc(size * sizeof(double));
+  prof->rate = (double *) malloc(size * sizeof(double));
+  nomem = (prof->start == NULL || prof->rate == NULL);
+  n = 0;
+  ended = FALSE;
+  while(!nomem && fgets(line, LINE_LEN, fp) != NULL)
+         {
+         if(line[0] == '#' || sscanf(line, "%s", word) < 1)
+                continue;
+         if(prof->linear < 0)
+                {
+                prof->linear = (strcmp(word, "linear") == 0);
+                if(!prof->linear && strcmp(word, "constant") != 0)
+                       break;
+                continue;
+                }
+         /* a time alone ends a constant profile */
+         fields = sscanf(line, "%lf %lf", &t, &r);
+         if(fields == 1 && !prof->linear)
+                r = 0;
+         if(ended || fields < (prof->linear ? 2 : 1) || r < 0 ||
+            (n == 0 && t != 0) || (n > 0 && t <= prof->start[n-1] / 100))
+                {
+                n = 0;
+                break;
+                }
+         if(n == size)
+                {
+                size *= 2;
+                if((grown = (double *) realloc(prof->start, size * sizeof(double))) != NULL)
+                       prof->start = grown;
+                if(grown != NULL &&
+                   (grown = (double *) realloc(prof->rate, size * sizeof(double))) != NULL)
+                       prof->rate = grown;
+                if(grown == NULL)
+                       {
+                       nomem = TRUE;
+                       break;
+                       }
+                }
+         prof->start[n] = t * 100;
+         prof->rate[n++] = r / 100;
+         ended = (fields == 1);
+         }
+  fclose(fp);
+  if(nomem || n < 2)
+         {
+         if(nomem)
+                printf(" ***Error - out of memory reading %s***\n", fname);
+         else
+                printf(" ***Error - bad rate profile %s***\n", fname);
+         free(prof->start);
+         free(prof->rate);
+         free(prof);
+         return(NULL);
+         }
+  /* majorant of each segment and the average rate */
+  prof->nseg = n - 1;
+  prof->major = (double *) malloc(prof->nseg * sizeof(double));
+  if(prof->major == NULL)
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         free(prof->start);
+         free(prof->rate);
+         free(prof);
+         return(NULL);
+         }
+  area = 0;
+  for(i = 0; i < prof->nseg; i++)
+         {
+         if(prof->linear)
+                {
+                prof->major[i] = fmax(prof->rate[i], prof->rate[i+1]);
+                area += (prof->rate[i] + prof->rate[i+1]) / 2 *
+                        (prof->start[i+1] - prof->start[i]);
+                }
+         else
+                {
+                prof->major[i] = prof->rate[i];
+                area += prof->rate[i] * (prof->start[i+1] - prof->start[i]);
+                }
+         }
+  prof->mean_rate = area / prof->start[prof->nseg];
+  if(area <= 0)
+         {
+         printf(" ***Error - rate profile %s has no arrivals***\n", fname);
+         free(prof->start);
+         free(prof->rate);
+         free(prof->major);
+         free(prof);
+         return(NULL);
+         }
+  return(prof);
+  }
+
+/*********************************************************************/
+/* Name: Profile_arrival                                             */
+/* Description                                                       */
+/*    This function returns the time of the next arrival after       */
+/* last_arrival for a non-homogeneous Poisson process with the given */
+/* rate profile, by Lewis-Shedler thinning.  Candidates are drawn at */
+/* the majorant rate of the current segment only, so few are        */
+/* rejected; a candidate past the end of the segment is dropped and  */
+/* drawing restarts at the next segment, which is exact because the  */
+/* exponential is memoryless.  Segments with rate 0 are skipped.     */
+/* The uniforms come from the arrival stream of customer cust.       */
+/*********************************************************************/
+double Profile_arrival(struct Sim_context *sim, struct Rate_profile *prof, unsigned long int cust)
+  {
+  double t, end, lam, frac;
+  int draw;
+  t = sim->last_arrival;
+  draw = 0;
+  while(TRUE)
+         {
+         end = sim->prof_base + prof->start[sim->prof_seg+1];
+         lam = prof->major[sim->prof_seg];
+         if(lam > 0)
+                t += -log(Uniform(sim, ARRIVAL_STREAM, cust, draw++)) / lam;
+         if(lam <= 0 || t >= end)
+                {
+                /* move on to the next segment, wrapping at the period */
+                t = end;
+                if(++sim->prof_seg == prof->nseg)
+                       {
+                       sim->prof_seg = 0;
+                       sim->prof_base = end;
+                       }
+                continue;
+                }
+         /* constant segments accept every candidate */
+         if(!prof->linear)
+                return(t);
+         frac = (t - sim->prof_base - prof->start[sim->prof_seg]) /
+                (prof->start[sim->prof_seg+1] - prof->start[sim->prof_seg]);
+         if(Uniform(sim, ARRIVAL_STREAM, cust, draw++) * lam <=
+            prof->rate[sim->prof_seg] +
+            frac * (prof->rate[sim->prof_seg+1] - prof->rate[sim->prof_seg]))
+                return(t);
+         }
+  }
+
+/*********************************************************************/
+/* Name: Load_mmpp                                                   */
+/* Description                                                       */
+/*    This function loads a Markov-modulated Poisson process.  Blank */
+/* lines and lines starting with # are ignored.  The file holds the  */
+/* number of phases n, then the n arrival rates, then the n by n     */
+/* matrix of phase transition rates (the diagonal is ignored).  Rates */
+/* are per unit of the mean interarrival time.  The process starts   */
+/* in phase 0.  Returns NULL if the file cannot be used.             */
+/*********************************************************************/
+struct Mmpp *Load_mmpp(char *fname)
+  {
+  FILE *fp;
+  char line[LINE_LEN], *pos, *end;
+  struct Mmpp *proc;
+  double *vals, *a, piv, q;
+  int n, nvals, need, i, j, k;
+  if((fp = fopen(fname, "r")) == NULL)
+         {
+         printf(" ***Error - cannot open MMPP file %s***\n", fname);
+         return(NULL);
+         }
+  /* read every number in the file */
+  n = 0;
+  nvals = 0;
+  need = 1;
+  vals = NULL;
+  while(nvals < need && fgets(line, LINE_LEN, fp) != NULL)
+         {
+         if(line[0] == '#')
+                continue;
+         for(pos = line; nvals < need; pos = end)
+                {
+                q = strtod(pos, &end);
+                if(end == pos)
+                       break;
+                if(n == 0)
+                       {
+                       n = (int) q;
+                       if(n < 1)
+                              break;
+                       need = n + n * n;
+                       vals = (double *) malloc(need * sizeof(double));
+                       if(vals == NULL)
+                              {
+                              printf(" ***Error - out of memory reading %s***\n", fname);
+                              fclose(fp);
+                              return(NULL);
+                              }
+                       continue;
+                       }
+                vals[nvals++] = q;
+                }
+         }
+  fclose(fp);
+  if(n < 1 || nvals < need)
+         {
+         printf(" ***Error - bad MMPP file %s***\n", fname);
+         free(vals);
+         return(NULL);
+         }
+  proc = (struct Mmpp *) calloc(1, sizeof(struct Mmpp));
+  if(proc != NULL)
+         {
+         proc->nphase = n;
+         proc->rate = (double *) malloc(n * sizeof(double));
+         proc->total = (double *) malloc(n * sizeof(double));
+         proc->cum = (double *) malloc(n * n * sizeof(double));
+         }
+  if(proc == NULL || proc->rate == NULL || proc->total == NULL || proc->cum == NULL)
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         Mmpp_free(proc);
+         free(vals);
+         return(NULL);
+         }
+  for(i = 0; i < n; i++)
+         {
+         proc->rate[i] = vals[i] / 100;
+         proc->total[i] = proc->rate[i];
+         for(j = 0; j < n; j++)
+                {
+                q = (i == j || vals[n + i*n + j] < 0) ? 0 : vals[n + i*n + j] / 100;
+                proc->total[i] += q;
+                proc->cum[i*n + j] = proc->total[i] - proc->rate[i];
+                }
+         }
+  free(vals);
+  /* stationary phase probabilities: solve pi Q = 0 with sum(pi) = 1 */
+  a = (double *) calloc(n * (n + 1), sizeof(double));
+  if(a == NULL)
+         {
+         printf(" ***Error - out of memory reading %s***\n", fname);
+         Mmpp_free(proc);
+         return(NULL);
+         }
+  for(i = 0; i < n; i++)
+         for(j = 0; j < n; j++)
+                {
+                /* row j of the system is column j of Q */
+                q = (i == j) ? -(proc->total[i] - proc->rate[i])
+                             : proc->cum[i*n + j] - (j > 0 ? proc->cum[i*n + j-1] : 0);
+                a[j*(n+1) + i] = q;
+                }
+  /* replace the last (dependent) equation with the normalization */
+  for(i = 0; i <= n; i++)
+         a[(n-1)*(n+1) + i] = 1;
+  for(k = 0; k < n; k++)
+         {
+         piv = a[k*(n+1) + k];
+         for(i = k + 1; fabs(piv) < 1e-300 && i < n; i++)
+                if(a[i*(n+1) + k] != 0)
+                       {
+                       for(j = 0; j <= n; j++)
+                              {
+                              q = a[k*(n+1) + j];
+                              a[k*(n+1) + j] = a[i*(n+1) + j];
+                              a[i*(n+1) + j] = q;
+                              }
+                       piv = a[k*(n+1) + k];
+                       }
+         if(fabs(piv) < 1e-300)
+                continue;
+         for(i = 0; i < n; i++)
+                if(i != k)
+                       {
+                       q = a[i*(n+1) + k] / piv;
+                       for(j = k; j <= n; j++)
+                              a[i*(n+1) + j] -= q * a[k*(n+1) + j];
+                       }
+         }
+  proc->mean_rate = 0;
+  for(i = 0; i < n; i++)
+         if(a[i*(n+1) + i] != 0)
+                proc->mean_rate += proc->rate[i] * a[i*(n+1) + n] / a[i*(n+1) + i];
+  free(a);
+  /* a phase with no arrivals and no way out would never end */
+  for(i = 0; i < n; i++)
+         if(proc->total[i] <= 0)
+                proc->mean_rate = 0;
+  if(proc->mean_rate <= 0)
+         {
+         printf(" ***Error - MMPP in %s has no arrivals***\n", fname);
+         Mmpp_free(proc);
+         return(NULL);
+         }
+  return(proc);
+  }
+
+/*********************************************************************/
+/* Name: Mmpp_free                                                   */
+/* Description                                                       */
+/*    This procedure frees an MMPP, including one only partly built. */
+/*********************************************************************/
+void Mmpp_free(struct Mmpp *proc)
+  {
+  if(proc == NULL)
+         return;
+  free(proc->rate);
+  free(proc->total);
+  free(proc->cum);
+  free(proc);
+  }
+
+/*********************************************************************/
+/* Name: Mmpp_arrival                                                */
+/* Description                                                       */
+/*    This function returns the time of the next arrival after       */
+/* last_arrival for a Markov-modulated Poisson process.  In each     */
+/* phase the next arrival and the next phase change race, so one     */
+/* exponential at the combined rate gives the time of whichever      */
+/* comes first and one uniform picks which it was (and the new phase */
+/* if it was a change).  Phase changes therefore never reach the     */
+/* event list, and a phase with no changes costs the same as plain   */
+/* Poisson arrivals.  The uniforms come from the arrival stream of   */
+/* customer cust.                                                    */
+/*********************************************************************/
+double Mmpp_arrival(struct Sim_context *sim, struct Mmpp *proc, unsigned long int cust)
+  {
+  double t, u, *row;
+  int draw, j;
+  t = sim->last_arrival;
+  draw = 0;
+  while(TRUE)
+         {
+         t += -log(Uniform(sim, ARRIVAL_STREAM, cust, draw++)) / proc->total[sim->mmpp_phase];
+         u = Uniform(sim, ARRIVAL_STREAM, cust, draw++) * proc->total[sim->mmpp_phase];
+         if(u < proc->rate[sim->mmpp_phase])
+                return(t);
+         /* phase change - the rest of u picks the new phase */
+         u -= proc->rate[sim->mmpp_phase];
+         row = proc->cum + sim->mmpp_phase * proc->nphase;
+         for(j = 0; j < proc->nphase - 1 && u >= row[j]; j++)
+                ;
+         sim->mmpp_phase = j;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Load_network                                                */
+/* Description                                                       */
+/*    This function reads a network file.  Each node has a line      */
+/*        node i mean_service min_service mean_interarrival          */
+/* giving a shifted exponential service time and the mean time       */
+/* between external arrivals (0 for none), with nodes numbered from  */
+/* 0 in order.  Lines                                                */
+/*        route i j probability                                      */
+/* send a job leaving node i to node j; jobs that take no route      */
+/* leave the network.  Lines starting with # are ignored.  The       */
+/* minimum service time is the lookahead of the parallel engine, so  */
+/* every node must have some.  It returns NULL if the file is bad.  */
+/*********************************************************************/
+struct Net_model *Load_network(char *fname)
+  {
+  FILE *fp;
+  char line[LINE_LEN], word[LINE_LEN];
+  struct Net_model *net;
+  double mean, lo, ia, p;
+  int i, j, n, ok, ext;
+  if((fp = fopen(fname, "r")) == NULL)
+         {
+         printf(" ***Error - cannot open network file %s***\n", fname);
+         return(NULL);
+         }
+  net = (struct Net_model *) calloc(1, sizeof(struct Net_model));
+  if(net == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         fclose(fp);
+         return(NULL);
+         }
+  net->service = (double *) malloc(NET_MAX_NODES * sizeof(double));
+  net->min_service = (double *) malloc(NET_MAX_NODES * sizeof(double));
+  net->min_ticks = (long int *) malloc(NET_MAX_NODES * sizeof(long int));
+  net->lookahead = (long int *) malloc(NET_MAX_NODES * sizeof(long int));
+  net->iarrive = (double *) malloc(NET_MAX_NODES * sizeof(double));
+  net->nroute = (int *) calloc(NET_MAX_NODES, sizeof(int));
+  net->dest = (int **) calloc(NET_MAX_NODES, sizeof(int *));
+  net->cum = (double **) calloc(NET_MAX_NODES, sizeof(double *));
+  if(net->service == NULL || net->min_service == NULL || net->min_ticks == NULL ||
+     net->lookahead == NULL || net->iarrive == NULL || net->nroute == NULL ||
+     net->dest == NULL || net->cum == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         fclose(fp);
+         Net_free(net);
+         return(NULL);
+         }
+  ok = TRUE;
+  while(ok && fgets(line, LINE_LEN, fp) != NULL)
+         {
+         if(line[0] == '#' || sscanf(line, "%s", word) < 1)
+                continue;
+         if(strcmp(word, "node") == 0)
+                {
+                n = sscanf(line, "%*s %d %lf %lf %lf", &i, &mean, &lo, &ia);
+                ok = (n == 4 && i == net->nnode && i < NET_MAX_NODES &&
+                      lo >= 0 && mean >= lo && ia >= 0);
+                if(!ok)
+                       break;
+                net->service[i] = mean;
+                net->min_service[i] = lo;
+                net->min_ticks[i] = (long int) ceil(lo * 100);
+                /* the exponential part is at least a tick unless it is absent */
+                net->lookahead[i] = net->min_ticks[i] + (mean > lo ? 1 : 0);
+                net->iarrive[i] = ia;
+                net->dest[i] = (int *) malloc(NET_MAX_ROUTES * sizeof(int));
+                net->cum[i] = (double *) malloc(NET_MAX_ROUTES * sizeof(double));
+                net->nnode++;
+                if(net->dest[i] == NULL || net->cum[i] == NULL)
+                       {
+                       printf(" ***Error - out of memory***\n");
+                       fclose(fp);
+                       Net_free(net);
+                       return(NULL);
+                       }
+                ok = (net->lookahead[i] > 0);
+                }
+         else if(strcmp(word, "route") == 0)
+                {
+                n = sscanf(line, "%*s %d %d %lf", &i, &j, &p);
+                ok = (n == 3 && i >= 0 && i < net->nnode && j >= 0 && j < NET_MAX_NODES &&
+                      p > 0 && net->nroute[i] < NET_MAX_ROUTES);
+                if(!ok)
+                       break;
+                net->dest[i][net->nroute[i]] = j;
+                net->cum[i][net->nroute[i]] = p + (net->nroute[i] > 0 ?
+                                                   net->cum[i][net->nroute[i] - 1] : 0);
+                ok = (net->cum[i][net->nroute[i]++] <= 1 + 1e-9);
+                }
+         else
+                ok = FALSE;
+         }
+  fclose(fp);
+  /* routes may name nodes defined later, and someone must arrive */
+  ext = FALSE;
+  for(i = 0; ok && i < net->nnode; i++)
+         {
+         for(j = 0; j < net->nroute[i]; j++)
+                ok = ok && net->dest[i][j] < net->nnode;
+         ext = ext || net->iarrive[i] > 0;
+         }
+  if(!ok || net->nnode == 0 || !ext)
+         {
+         printf(" ***Error - bad network file %s***\n", fname);
+         Net_free(net);
+         return(NULL);
+         }
+  return(net);
+  }
+
+/*********************************************************************/
+/* Name: Net_free                                                    */
+/* Description                                                       */
+/*    This procedure frees a network, whole or partly built.         */
+/*********************************************************************/
+void Net_free(struct Net_model *net)
+  {
+  int i;
+  for(i = 0; i < net->nnode; i++)
+         {
+         free(net->dest[i]);
+         free(net->cum[i]);
+         }
+  free(net->service);
+  free(net->min_service);
+  free(net->min_ticks);
+  free(net->lookahead);
+  free(net->iarrive);
+  free(net->nroute);
+  free(net->dest);
+  free(net->cum);
+  free(net);
+  }
+
+/*********************************************************************/
+/* Name: Load_sweep                                                  */
+/* Description                                                       */
+/*    This function reads a sweep file.  The first word is "grid" or */
+/* "list".  A grid has lines naming an axis (iarrive, service or     */
+/* seed) followed by its values, each a number or lo:hi:step, and    */
+/* runs every combination.  A list has one point per line, giving    */
+/* iarrive, service and seed.  Lines starting with # are ignored.    */
+/* It returns NULL if the file cannot be read.                       */
+/*********************************************************************/
+struct Sweep *Load_sweep(char *fname)
+  {
+  FILE *fp;
+  char line[LINE_LEN], word[LINE_LEN], *tok;
+  struct Sweep *sw;
+  double lo, hi, step, v[3];
+  int a, n, ok, size[3];
+  long int i, psize;
+  if((fp = fopen(fname, "r")) == NULL)
+         {
+         printf(" ***Error - cannot open sweep file %s***\n", fname);
+         return(NULL);
+         }
+  sw = (struct Sweep *) calloc(1, sizeof(struct Sweep));
+  sw->grid = -1;
+  psize = 0;
+  for(a = 0; a < 3; a++)
+         size[a] = 0;
+  ok = TRUE;
+  while(ok && fgets(line, LINE_LEN, fp) != NULL)
+         {
+         if(line[0] == '#' || sscanf(line, "%s", word) < 1)
+                continue;
+         if(sw->grid < 0)
+                {
+                sw->grid = (strcmp(word, "grid") == 0);
+                ok = sw->grid || strcmp(word, "list") == 0;
+                continue;
+                }
+         if(!sw->grid)
+                {
+                if(sscanf(line, "%lf %lf %lf", &v[0], &v[1], &v[2]) < 3 ||
+                   v[0] <= 0 || v[1] <= 0 || v[2] < 0)
+                       {
+                       ok = FALSE;
+                       break;
+                       }
+                if(sw->npoint == psize)
+                       {
+                       psize = psize ? 2 * psize : 64;
+                       sw->point = (double *) realloc(sw->point, 3 * psize * sizeof(double));
+                       }
+                for(a = 0; a < 3; a++)
+                       sw->point[3 * sw->npoint + a] = v[a];
+                sw->npoint++;
+                continue;
+                }
+         /* grid axis - a name then numbers or lo:hi:step ranges */
+         a = (strcmp(word, "iarrive") == 0) ? 0 : (strcmp(word, "service") == 0) ? 1 :
+             (strcmp(word, "seed") == 0) ? 2 : -1;
+         if(a < 0 || sw->naxis[a] > 0)
+                {
+                ok = FALSE;
+                break;
+                }
+         strtok(line, " \t\r\n");
+         while((tok = strtok(NULL, " \t\r\n")) != NULL)
+                {
+                n = sscanf(tok, "%lf:%lf:%lf", &lo, &hi, &step);
+                if(n == 1)
+                       {
+                       hi = lo;
+                       step = 1;
+                       }
+                else if(n != 3 || step <= 0 || hi < lo)
+                       {
+                       ok = FALSE;
+                       break;
+                       }
+                if(lo < 0 || (a < 2 && lo <= 0))
+                       {
+                       ok = FALSE;
+                       break;
+                       }
+                /* allow for rounding in the last step of the range */
+                for(i = 0; lo + i * step <= hi + step * 1e-6; i++)
+                       {
+                       if(sw->naxis[a] == size[a])
+                              {
+                              size[a] = size[a] ? 2 * size[a] : 16;
+                              sw->axis[a] = (double *) realloc(sw->axis[a],
+                                                               size[a] * sizeof(double));
+                              }
+                       sw->axis[a][sw->naxis[a]++] = lo + i * step;
+                       }
+                }
+         if(sw->naxis[a] == 0)
+                ok = FALSE;
+         }
+  fclose(fp);
+  if(!ok || sw->grid < 0 || (!sw->grid && sw->npoint == 0))
+         {
+         printf(" ***Error - bad sweep file %s***\n", fname);
+         for(a = 0; a < 3; a++)
+                free(sw->axis[a]);
+         free(sw->point);
+         free(sw);
+         return(NULL);
+         }
+  return(sw);
+  }
+
+/*********************************************************************/
+/* Name: Stat_init                                                   */
+/* Description                                                       */
+/*    This procedure empties a streaming statistic.                  */
+/*********************************************************************/
+void Stat_init(struct Stat *st)
+  {
+  st->count = 0;
+  st->sum = 0;
+  st->comp = 0;
+  st->mean = 0;
+  st->m2 = 0;
+  st->min = MAXDOUBLE;
+  st->max = -MAXDOUBLE;
+  }
+
+/*********************************************************************/
+/* Name: Stat_record                                                 */
+/* Description                                                       */
+/*    This procedure adds an observation to a streaming statistic.   */
+/* The count is an exact 64 bit integer, the sum is compensated      */
+/* (Kahan) and the variance is updated with Welford's method, so     */
+/* neither loses precision over billions of observations.            */
+/*********************************************************************/
+void Stat_record(struct Stat *st, double x)
+  {
+  double y, t, delta;
+  st->count++;
+  /* compensated sum */
+  y = x - st->comp;
+  t = st->sum + y;
+  st->comp = (t - st->sum) - y;
+  st->sum = t;
+  /* Welford update of mean and squared deviations */
+  delta = x - st->mean;
+  st->mean += delta / st->count;
+  st->m2 += delta * (x - st->mean);
+  if(x < st->min) st->min = x;
+  if(x > st->max) st->max = x;
+  }
+
+/*********************************************************************/
+/* Name: Stat_merge                                                  */
+/* Description                                                       */
+/*    This procedure adds the observations of other into st, using   */
+/* Chan's formula to combine the squared deviations.                 */
+/*********************************************************************/
+void Stat_merge(struct Stat *st, struct Stat *other)
+  {
+  double delta, n, y, t;
+  if(other->count == 0)
+         return;
+  n = (double) st->count + other->count;
+  delta = other->mean - st->mean;
+  st->m2 += other->m2 + delta * delta * ((double) st->count * other->count / n);
+  st->mean += delta * (other->count / n);
+  y = other->sum - (st->comp + other->comp);
+  t = st->sum + y;
+  st->comp = (t - st->sum) - y;
+  st->sum = t;
+  st->count += other->count;
+  if(other->min < st->min) st->min = other->min;
+  if(other->max > st->max) st->max = other->max;
+  }
+
+/*********************************************************************/
+/* Name: Stat_mean                                                   */
+/* Description                                                       */
+/*    This function returns the mean of a streaming statistic, from  */
+/* the compensated sum.  It is 0 when there are no observations.     */
+/*********************************************************************/
+double Stat_mean(struct Stat *st)
+  {
+  if(st->count == 0)
+         return(0);
+  return(st->sum / st->count);
+  }
+
+/*********************************************************************/
+/* Name: Stat_var                                                    */
+/* Description                                                       */
+/*    This function returns the sample variance of a streaming       */
+/* statistic, or 0 with fewer than two observations.                 */
+/*********************************************************************/
+double Stat_var(struct Stat *st)
+  {
+  if(st->count < 2)
+         return(0);
+  return(st->m2 / (st->count - 1));
+  }
+
+/*********************************************************************/
+/* Name: Stat_stddev                                                 */
+/* Description                                                       */
+/*    This function returns the sample standard deviation.           */
+/*********************************************************************/
+double Stat_stddev(struct Stat *st)
+  {
+  return(sqrt(Stat_var(st)));
+  }
+
+/*********************************************************************/
+/* Name: Hdr_init                                                    */
+/* Description                                                       */
+/*    This procedure empties a histogram.                            */
+/*********************************************************************/
+void Hdr_init(struct Hdr_hist *h)
+  {
+  memset(h, 0, sizeof(struct Hdr_hist));
+  }
+
+/*********************************************************************/
+/* Name: Hdr_record                                                  */
+/* Description                                                       */
+/*    This procedure counts a value in its histogram bucket.  The    */
+/* bucket comes from the position of the highest set bit and the     */
+/* next HDR_SUB_BITS-1 bits, so recording is a few instructions      */
+/* whatever the value.  Negative values are counted as 0.            */
+/*********************************************************************/
+void Hdr_record(struct Hdr_hist *h, long int value)
+  {
+  unsigned long long v;
+  int shift;
+  v = (value > 0) ? (unsigned long long) value : 0;
+  h->count++;
+  if(v < HDR_SUB)
+         {
+         h->bucket[v]++;
+         return;
+         }
+  shift = 63 - __builtin_clzll(v) - HDR_SUB_BITS + 1;
+  h->bucket[HDR_SUB + (shift - 1) * HDR_HALF + (int) (v >> shift) - HDR_HALF]++;
+  }
+
+/*********************************************************************/
+/* Name: Hdr_merge                                                   */
+/* Description                                                       */
+/*    This procedure adds the counts of histogram other into h.      */
+/* Histograms from separate replications merge exactly.              */
+/*********************************************************************/
+void Hdr_merge(struct Hdr_hist *h, struct Hdr_hist *other)
+  {
+  int i;
+  h->count += other->count;
+  for(i = 0; i < HDR_BUCKETS; i++)
+         h->bucket[i] += other->bucket[i];
+  }
+
+/*********************************************************************/
+/* Name: Hdr_percentile                                              */
+/* Description                                                       */
+/*    This function returns the value at the given percentile        */
+/* (0-100) of a histogram, as the middle of the bucket holding it.   */
+/*********************************************************************/
+double Hdr_percentile(struct Hdr_hist *h, double pct)
+  {
+  unsigned long long rank, seen;
+  int i, j, shift;
+  if(h->count == 0)
+         return(0);
+  /* rank of the wanted value, counting from 1 */
+  rank = (unsigned long long) ceil(pct / 100 * h->count);
+  if(rank < 1)
+         rank = 1;
+  seen = 0;
+  for(i = 0; i < HDR_BUCKETS - 1; i++)
+         {
+         seen += h->bucket[i];
+         if(seen >= rank)
+                break;
+         }
+  if(i < HDR_SUB)
+         return(i);
+  j = i - HDR_SUB;
+  shift = j / HDR_HALF + 1;
+  return(ldexp(HDR_HALF + j % HDR_HALF + 0.5, shift));
+  }
+
+/*********************************************************************/
+/* Name: Print_percentiles                                           */
+/* Description                                                       */
+/*    This procedure prints the configured percentiles of a          */
+/* histogram, labelled with what the histogram measures.             */
+/*********************************************************************/
+void Print_percentiles(struct Sim_parms *parms, struct Hdr_hist *h, char *what)
+  {
+  int i, len;
+  char label[32];
+  for(i = 0; i < parms->num_pct; i++)
+         {
+         /* pad the label with dashes to line up with the other results */
+         len = snprintf(label, 30, " p%g %s ", parms->pct_list[i], what);
+         while(len < 29)
+                label[len++] = '-';
+         label[len] = '\0';
+         printf("%s> %-6.3f\n", label, Hdr_percentile(h, parms->pct_list[i]) / 100.0);
+         }
+  }
+
+/*********************************************************************/
+/* Name: Parse_percentiles                                           */
+/* Description                                                       */
+/*    This function sets the percentiles to report from a comma      */
+/* separated list.  Returns FALSE if the list is not valid.          */
+/*********************************************************************/
+int Parse_percentiles(struct Sim_parms *parms, char *list)
+  {
+  char *pos, *end;
+  double p;
+  parms->num_pct = 0;
+  for(pos = list; *pos != '\0'; pos = end + (*end == ','))
+         {
+         p = strtod(pos, &end);
+         if(end == pos || p < 0 || p > 100 || parms->num_pct == MAX_PCT)
+                {
+                printf(" ***Error - bad percentile list %s***\n", list);
+                return(FALSE);
+                }
+         parms->pct_list[parms->num_pct++] = p;
+         }
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: P2_init                                                     */
+/* Description                                                       */
+/*    This procedure starts a P-square estimate of quantile p (0-1). */
+/*********************************************************************/
+void P2_init(struct P2_quant *est, double p)
+  {
+  int i;
+  est->p = p;
+  est->count = 0;
+  for(i = 0; i < 5; i++)
+         {
+         est->q[i] = 0;
+         est->n[i] = i;
+         }
+  est->want[0] = 0;
+  est->want[1] = 2 * p;
+  est->want[2] = 4 * p;
+  est->want[3] = 2 + 2 * p;
+  est->want[4] = 4;
+  }
+
+/*********************************************************************/
+/* Name: P2_record                                                   */
+/* Description                                                       */
+/*    This procedure adds an observation to a P-square estimate      */
+/* (Jain and Chlamtac).  Five markers track the minimum, the         */
+/* quantile, the two points half way to it and the maximum; each    */
+/* observation moves marker positions, and a marker that drifts      */
+/* from its desired position has its height adjusted by a parabolic  */
+/* (or, failing that, linear) fit.  Memory is constant.              */
+/*********************************************************************/
+void P2_record(struct P2_quant *est, double x)
+  {
+  int i, k, d;
+  double qp, t;
+  /* the first five observations fill the markers directly */
+  if(est->count < 5)
+         {
+         est->q[est->count++] = x;
+         for(i = est->count - 1; i > 0 && est->q[i] < est->q[i-1]; i--)
+                {
+                t = est->q[i];
+                est->q[i] = est->q[i-1];
+                est->q[i-1] = t;
+                }
+         return;
+         }
+  est->count++;
+  /* find the cell holding x, stretching the end markers if needed */
+  if(x < est->q[0])
+         {
+         est->q[0] = x;
+         k = 0;
+         }
+  else if(x >= est->q[4])
+         {
+         est->q[4] = x;
+         k = 3;
+         }
+  else
+         for(k = 0; k < 3 && x >= est->q[k+1]; k++)
+                ;
+  for(i = k + 1; i < 5; i++)
+         est->n[i]++;
+  est->want[1] += est->p / 2;
+  est->want[2] += est->p;
+  est->want[3] += (1 + est->p) / 2;
+  est->want[4] += 1;
+  /* adjust the middle markers */
+  for(i = 1; i < 4; i++)
+         {
+         t = est->want[i] - est->n[i];
+         if((t >= 1 && est->n[i+1] - est->n[i] > 1) ||
+            (t <= -1 && est->n[i-1] - est->n[i] < -1))
+                {
+                d = (t > 0) ? 1 : -1;
+                qp = est->q[i] + d / (est->n[i+1] - est->n[i-1]) *
+                     ((est->n[i] - est->n[i-1] + d) * (est->q[i+1] - est->q[i]) /
+                      (est->n[i+1] - est->n[i]) +
+                      (est->n[i+1] - est->n[i] - d) * (est->q[i] - est->q[i-1]) /
+                      (est->n[i] - est->n[i-1]));
+                if(qp <= est->q[i-1] || qp >= est->q[i+1])
+                       qp = est->q[i] + d * (est->q[i+d] - est->q[i]) /
+                            (est->n[i+d] - est->n[i]);
+                est->q[i] = qp;
+                est->n[i] += d;
+                }
+         }
+  }
+
+/*********************************************************************/
+/* Name: P2_merge                                                    */
+/* Description                                                       */
+/*    This procedure combines P-square estimate other into est.  The */
+/* algorithm has no exact merge, so marker heights are averaged by   */
+/* weight and positions added; this is adequate for replications of  */
+/* the same model.  Use the t-digest when merges must be accurate.   */
+/*********************************************************************/
+void P2_merge(struct P2_quant *est, struct P2_quant *other)
+  {
+  int i;
+  double w;
+  if(other->count == 0)
+         return;
+  if(est->count < 5 || other->count < 5)
+         {
+         /* too few values for markers - replay the raw observations */
+         if(other->count < 5)
+                for(i = 0; i < (int) other->count; i++)
+                       P2_record(est, other->q[i]);
+         else
+                {
+                struct P2_quant tmp = *other;
+                for(i = 0; i < (int) est->count; i++)
+                       P2_record(&tmp, est->q[i]);
+                *est = tmp;
+                }
+         return;
+         }
+  w = (double) other->count / (est->count + other->count);
+  for(i = 0; i < 5; i++)
+         {
+         est->q[i] += w * (other->q[i] - est->q[i]);
+         est->n[i] += other->n[i] + (i > 0);
+         est->want[i] += other->want[i] + (i > 0);
+         }
+  est->q[0] = fmin(est->q[0], other->q[0]);
+  est->q[4] = fmax(est->q[4], other->q[4]);
+  est->count += other->count;
+  }
+
+/*********************************************************************/
+/* Name: P2_value                                                    */
+/* Description                                                       */
+/*    This function returns the current P-square quantile estimate.  */
+/* With fewer than five observations the nearest one is returned.    */
+/*********************************************************************/
+double P2_value(struct P2_quant *est)
+  {
+  if(est->count == 0)
+         return(0);
+  if(est->count < 5)
+         return(est->q[(int) (est->p * (est->count - 1) + 0.5)]);
+  return(est->q[2]);
+  }
+
+/*********************************************************************/
+/* Name: Td_init                                                     */
+/* Description                                                       */
+/*    This procedure empties a t-digest.                             */
+/*********************************************************************/
+void Td_init(struct T_digest *td)
+  {
+  td->ncent = 0;
+  td->nbuf = 0;
+  td->total = 0;
+  td->min = MAXDOUBLE;
+  td->max = -MAXDOUBLE;
+  }
+
+/*********************************************************************/
+/* Name: Td_add                                                      */
+/* Description                                                       */
+/*    This procedure adds value x with weight w to a t-digest.  It   */
+/* goes into the buffer, which is merged in when it fills.           */
+/*********************************************************************/
+void Td_add(struct T_digest *td, double x, double w)
+  {
+  if(td->nbuf == TD_BUFFER)
+         Td_compress(td);
+  td->buf[td->nbuf].mean = x;
+  td->buf[td->nbuf++].weight = w;
+  td->total += w;
+  if(x < td->min) td->min = x;
+  if(x > td->max) td->max = x;
+  }
+
+/*********************************************************************/
+/* Name: Td_compress                                                 */
+/* Description                                                       */
+/*    This procedure merges the buffered values into the centroids   */
+/* (the merging t-digest of Dunning).  Everything is sorted by mean  */
+/* and neighbours are combined while the result stays inside one     */
+/* unit of the scale function k(q) = C/(2 pi) asin(2q-1), which keeps */
+/* centroids small near the tails and bounds their number by C.     */
+/*********************************************************************/
+void Td_compress(struct T_digest *td)
+  {
+  struct Centroid all[TD_CENTROIDS + TD_BUFFER], cur;
+  int n, i;
+  double sofar, limit, k;
+  if(td->nbuf == 0)
+         return;
+  n = td->ncent;
+  memcpy(all, td->cent, n * sizeof(struct Centroid));
+  memcpy(all + n, td->buf, td->nbuf * sizeof(struct Centroid));
+  n += td->nbuf;
+  td->nbuf = 0;
+  qsort(all, n, sizeof(struct Centroid), Centroid_cmp);
+  td->ncent = 0;
+  cur = all[0];
+  sofar = 0;
+  /* largest cumulative weight the current centroid may reach */
+  k = TD_COMPRESSION / (2 * M_PI) * asin(2 * 0 - 1);
+  limit = td->total * (sin(2 * M_PI * (k + 1) / TD_COMPRESSION) + 1) / 2;
+  for(i = 1; i < n; i++)
+         {
+         if(sofar + cur.weight + all[i].weight <= limit)
+                {
+                cur.weight += all[i].weight;
+                cur.mean += (all[i].mean - cur.mean) * all[i].weight / cur.weight;
+                continue;
+                }
+         td->cent[td->ncent++] = cur;
+         sofar += cur.weight;
+         k = TD_COMPRESSION / (2 * M_PI) * asin(fmin(2 * sofar / td->total - 1, 1));
+         limit = (k + 1 >= TD_COMPRESSION / 4.0) ? td->total :
+                 td->total * (sin(2 * M_PI * (k + 1) / TD_COMPRESSION) + 1) / 2;
+         cur = all[i];
+         }
+  td->cent[td->ncent++] = cur;
+  }
+
+/*********************************************************************/
+/* Name: Td_merge                                                    */
+/* Description                                                       */
+/*    This procedure adds t-digest other into td, feeding its        */
+/* centroids in as weighted values.                                  */
+/*********************************************************************/
+void Td_merge(struct T_digest *td, struct T_digest *other)
+  {
+  int i;
+  double min, max;
+  min = other->min;
+  max = other->max;
+  for(i = 0; i < other->ncent; i++)
+         Td_add(td, other->cent[i].mean, other->cent[i].weight);
+  for(i = 0; i < other->nbuf; i++)
+         Td_add(td, other->buf[i].mean, other->buf[i].weight);
+  if(min < td->min) td->min = min;
+  if(max > td->max) td->max = max;
+  }
+
+/*********************************************************************/
+/* Name: Td_quantile                                                 */
+/* Description                                                       */
+/*    This function returns quantile q (0-1) of a t-digest by        */
+/* interpolating between the centres of neighbouring centroids, and  */
+/* between the end centroids and the minimum and maximum.            */
+/*********************************************************************/
+double Td_quantile(struct T_digest *td, double q)
+  {
+  double target, sofar, mid, next;
+  int i;
+  Td_compress(td);
+  if(td->ncent == 0)
+         return(0);
+  target = q * td->total;
+  /* below the centre of the first centroid */
+  mid = td->cent[0].weight / 2;
+  if(target <= mid)
+         return(td->min + (td->cent[0].mean - td->min) * (mid > 0 ? target / mid : 0));
+  sofar = 0;
+  for(i = 0; i < td->ncent - 1; i++)
+         {
+         mid = sofar + td->cent[i].weight / 2;
+         next = sofar + td->cent[i].weight + td->cent[i+1].weight / 2;
+         if(target <= next)
+                return(td->cent[i].mean + (td->cent[i+1].mean - td->cent[i].mean) *
+                       (target - mid) / (next - mid));
+         sofar += td->cent[i].weight;
+         }
+  /* above the centre of the last centroid */
+  mid = sofar + td->cent[i].weight / 2;
+  if(td->total <= mid)
+         return(td->max);
+  return(td->cent[i].mean + (td->max - td->cent[i].mean) *
+         (target - mid) / (td->total - mid));
+  }
+
+/*********************************************************************/
+/* Name: Centroid_cmp                                                */
+/* Description                                                       */
+/*    This function orders centroids by mean for qsort.              */
+/*********************************************************************/
+int Centroid_cmp(const void *a, const void *b)
+  {
+  double x, y;
+  x = ((const struct Centroid *) a)->mean;
+  y = ((const struct Centroid *) b)->mean;
+  return((x > y) - (x < y));
+  }
+
+/*********************************************************************/
+/* Name: Print_sketches                                              */
+/* Description                                                       */
+/*    This procedure prints the configured response time percentiles */
+/* as estimated by the P-square markers and the t-digest.            */
+/*********************************************************************/
+void Print_sketches(struct Sim_parms *parms, struct P2_quant *est, struct T_digest *td)
+  {
+  int i, len;
+  char label[64];
+  for(i = 0; i < parms->num_pct; i++)
+         {
+         len = sprintf(label, " p%g P2 / t-digest ", parms->pct_list[i]);
+         while(len < 29)
+                label[len++] = '-';
+         label[len] = '\0';
+         printf("%s> %-6.3f / %-6.3f\n", label, P2_value(&est[i]) / 100.0,
+                Td_quantile(td, parms->pct_list[i] / 100) / 100.0);
+         }
+  }
+
+/*********************************************************************/
+/* Name: Batch_init                                                  */
+/* Description                                                       */
+/*    This procedure empties a set of batch means.                   */
+/*********************************************************************/
+void Batch_init(struct Batch_means *bm)
+  {
+  bm->size = FIRST_BATCH;
+  bm->nbatch = 0;
+  bm->inbatch = 0;
+  bm->cur = 0;
+  }
+
+/*********************************************************************/
+/* Name: Batch_record                                                */
+/* Description                                                       */
+/*    This function adds an observation to the current batch.  When  */
+/* the table of batch means is full, neighbouring batches are        */
+/* averaged in pairs and the batch size doubles, so the memory is    */
+/* fixed and batches grow with the run, as they must for the batch   */
+/* means to become independent.  Returns TRUE if a batch completed.  */
+/*********************************************************************/
+int Batch_record(struct Batch_means *bm, double x)
+  {
+  int i;
+  bm->cur += x;
+  if(++bm->inbatch < bm->size)
+         return(FALSE);
+  bm->mean[bm->nbatch++] = bm->cur / bm->size;
+  bm->cur = 0;
+  bm->inbatch = 0;
+  if(bm->nbatch == MAX_BATCHES)
+         {
+         for(i = 0; i < MAX_BATCHES / 2; i++)
+                bm->mean[i] = (bm->mean[2*i] + bm->mean[2*i+1]) / 2;
+         bm->nbatch = MAX_BATCHES / 2;
+         bm->size *= 2;
+         }
+  return(TRUE);
+  }
+
+/*********************************************************************/
+/* Name: Batch_ci                                                    */
+/* Description                                                       */
+/*    This function returns the half-width of the 95% confidence     */
+/* interval from the complete batches after the first skip, and sets */
+/* mean to their grand mean and corr to the lag 1 correlation of the */
+/* batch means, which should be near 0 if the batches are long       */
+/* enough.                                                           */
+/*********************************************************************/
+double Batch_ci(struct Batch_means *bm, long int skip, double *mean, double *corr)
+  {
+  struct Stat st;
+  double cov;
+  long int i, n;
+  n = bm->nbatch - skip;
+  Stat_init(&st);
+  for(i = skip; i < bm->nbatch; i++)
+         Stat_record(&st, bm->mean[i]);
+  *mean = Stat_mean(&st);
+  *corr = 0;
+  if(n < 2)
+         return(0);
+  cov = 0;
+  for(i = skip + 1; i < bm->nbatch; i++)
+         cov += (bm->mean[i] - *mean) * (bm->mean[i-1] - *mean);
+  if(st.m2 > 0)
+         *corr = cov / st.m2;
+  return(T_quantile(0.975, n - 1) * sqrt(Stat_var(&st) / n));
+  }
+
+/*********************************************************************/
+/* Name: Warmup_batches                                              */
+/* Description                                                       */
+/*    This function returns how many response time batches lie even  */
+/* partly in the warm-up found by MSER-5, at most half of them.  The */
+/* two tables batch the same customers in the same order, so the     */
+/* warm-up is just a count of customers in both.                     */
+/*********************************************************************/
+long int Warmup_batches(struct Sim_context *sim)
+  {
+  struct Batch_means *bm;
+  double mean;
+  long int d, skip;
+  bm = &sim->resp_batch;
+  d = Mser_truncate(&sim->resp_mser, &mean);
+  skip = (d * sim->resp_mser.size + bm->size - 1) / bm->size;
+  if(skip > bm->nbatch / 2)
+         skip = bm->nbatch / 2;
+  return(skip);
+  }
+
+/*********************************************************************/
+/* Name: Check_stop                                                  */
+/* Description                                                       */
+/*    This procedure applies the sequential stopping rule after a    */
+/* batch of response times completes.  The batches in the MSER       */
+/* warm-up are dropped; once there are enough batches left, they     */
+/* look uncorrelated and the relative CI half-width is below the     */
+/* target, an end of simulation is scheduled for now.  Until then    */
+/* the run continues, past sim_length if need be, up to max_length.  */
+/*********************************************************************/
+void Check_stop(struct Sim_context *sim)
+  {
+  double half, mean, corr;
+  long int skip;
+  if(sim->resp_batch.nbatch < MIN_BATCHES)
+         return;
+  skip = Warmup_batches(sim);
+  if(sim->resp_batch.nbatch - skip < MIN_BATCHES)
+         return;
+  half = Batch_ci(&sim->resp_batch, skip, &mean, &corr);
+  if(mean > 0 && corr < MAX_CORR && half / mean < sim->parms->seq_target)
+         {
+         Insert_event(sim, EOS, sim->clock, NULL);
+         sim->stop_scheduled = TRUE;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Mser_init                                                   */
+/* Description                                                       */
+/*    This procedure empties the MSER batch table.                   */
+/*********************************************************************/
+void Mser_init(struct Mser *ms)
+  {
+  ms->size = MSER_BATCH;
+  ms->nbatch = 0;
+  ms->inbatch = 0;
+  ms->cur = 0;
+  }
+
+/*********************************************************************/
+/* Name: Mser_record                                                 */
+/* Description                                                       */
+/*    This procedure adds an observation, made at time now, to the   */
+/* MSER batch table.  When the table is full neighbouring batches    */
+/* are merged in pairs, so memory is fixed and the truncation point  */
+/* can be placed to within one batch, MSER_MAX/2 batches of the run. */
+/*********************************************************************/
+void Mser_record(struct Mser *ms, double x, long int now)
+  {
+  int i;
+  ms->cur += x;
+  if(++ms->inbatch < ms->size)
+         return;
+  ms->mean[ms->nbatch] = ms->cur / ms->size;
+  ms->end_time[ms->nbatch++] = now;
+  ms->cur = 0;
+  ms->inbatch = 0;
+  if(ms->nbatch == MSER_MAX)
+         {
+         for(i = 0; i < MSER_MAX / 2; i++)
+                {
+                ms->mean[i] = (ms->mean[2*i] + ms->mean[2*i+1]) / 2;
+                ms->end_time[i] = ms->end_time[2*i+1];
+                }
+         ms->nbatch = MSER_MAX / 2;
+         ms->size *= 2;
+         }
+  }
+
+/*********************************************************************/
+/* Name: Mser_truncate                                               */
+/* Description                                                       */
+/*    This function finds the warm-up period by the MSER rule: the   */
+/* number of batches d, at most half of them, that minimizes the     */
+/* squared standard error of the mean of the batches left,           */
+/*     sum over i > d of (Z(i) - mean)^2 / (n - d)^2.                */
+/* It returns d and sets mean to the mean of the batches after it.   */
+/* Suffix sums make this one pass over the table.                    */
+/*********************************************************************/
+long int Mser_truncate(struct Mser *ms, double *mean)
+  {
+  long int n, d, best;
+  double sum, sumsq, m, stat, beststat;
+  n = ms->nbatch;
+  *mean = 0;
+  if(n == 0)
+         return(0);
+  sum = 0;
+  sumsq = 0;
+  best = n - 1;
+  beststat = MAXDOUBLE;
+  for(d = n - 1; d >= 0; d--)
+         {
+         sum += ms->mean[d];
+         sumsq += ms->mean[d] * ms->mean[d];
+         if(d > n / 2)
+                continue;
+         m = sum / (n - d);
+         stat = (sumsq - sum * m) / ((double) (n - d) * (n - d));
+         if(stat <= beststat)
+                {
+                beststat = stat;
+                best = d;
+                *mean = m;
+                }
+         }
+  return(best);
+  }
+
+/*********************************************************************/
+/* Name: Update_time_avg                                             */
+/* Description                                                       */
+/*    This procedure adds the areas under the number in queue, the   */
+/* number in system, the busy flag and the unfinished work from the  */
+/* last update up to time now.  It is called for every event before  */
+/* the clock moves, and is O(1).  Nothing changes between events     */
+/* except the work, which drains at rate 1 while the server is busy, */
+/* so its area over dt is a trapezoid.                               */
+/*********************************************************************/
+void Update_time_avg(struct Sim_context *sim, long int now)
+  {
+  double dt;
+  dt = (double) (now - sim->tavg.last);
+  if(dt <= 0)
+         return;
+  sim->tavg.queue += sim->num_in_queue * dt;
+  sim->tavg.system += (sim->num_in_queue + sim->busy) * dt;
+  if(sim->busy)
+         {
+         sim->tavg.busy += dt;
+         sim->tavg.work += sim->unfinished * dt - dt * dt / 2;
+         sim->unfinished -= dt;
+         }
+  sim->tavg.last = now;
+  }
+
+/*********************************************************************/
+/* Name: Record_class                                                */
+/* Description                                                       */
+/*    This procedure records a departing customer's response time,   */
+/* waiting time and slowdown in the statistics of its job size       */
+/* class, chosen from the highest set bit of the burst time.  It     */
+/* costs a few fixed array updates per departure.                    */
+/*********************************************************************/
+void Record_class(struct Sim_context *sim, long int resp, long int wait, long int burst)
+  {
+  struct Size_class *cl;
+  int k;
+  if(burst < 1)
+         burst = 1;
+  k = 63 - __builtin_clzll((unsigned long long) burst);
+  if(k >= NUM_CLASSES)
+         k = NUM_CLASSES - 1;
+  cl = &sim->size_class[k];
+  Stat_record(&cl->resp, resp);
+  Stat_record(&cl->wait, wait);
+  Stat_record(&cl->slowdown, (double) resp / burst);
+  P2_record(&cl->tail, resp);
+  }
+
+/*********************************************************************/
+/* Name: Print_classes                                               */
+/* Description                                                       */
+/*    This procedure prints the response time breakdown by job size  */
+/* class, one line for every class that saw a customer.              */
+/*********************************************************************/
+void Print_classes(struct Sim_context *sim)
+  {
+  int k;
+  struct Size_class *cl;
+  printf(" Results by burst size\n");
+  printf("   burst from      custs  mean resp    p%g resp  mean wait   slowdown\n",
+         CLASS_PCT * 100);
+  for(k = 0; k < NUM_CLASSES; k++)
+         {
+         cl = &sim->size_class[k];
+         if(cl->resp.count == 0)
+                continue;
+         printf(" %12.2f %10llu %10.3f %10.3f %10.3f %10.3f\n", ldexp(1, k) / 100.0,
+                cl->resp.count, Stat_mean(&cl->resp) / 100.0,
+                P2_value(&cl->tail) / 100.0, Stat_mean(&cl->wait) / 100.0,
+                Stat_mean(&cl->slowdown));
+         }
+  }
+
+/*********************************************************************/
+/* Name: Analytic_sjf                                                */
+/* Description                                                       */
+/*    This function returns the mean response time of an M/G/1 queue */
+/* with non-preemptive SJF scheduling (Phipps), for the input mean   */
+/* interarrival time and either exponential service or the           */
+/* empirical burst distribution.  A job of size x waits on average   */
+/*     W(x) = W0 / ((1 - rho(x-)) (1 - rho(x)))                      */
+/* where W0 = lambda E[S^2] / 2 is the mean residual work found in   */
+/* service and rho(x) is the load of jobs no longer than x.  The     */
+/* mean response time is E[S] plus W(x) averaged over job sizes.     */
+/*    For exponential service the integral is taken over u = x/mean  */
+/* by adaptive Simpson, which puts its points where the load of      */
+/* shorter jobs climbs fastest, up to a u past which the tail is     */
+/* below ANALYTIC_TOL; that tail is added in closed form.  A warning */
+/* is printed if the rule cannot meet its tolerance.  (Written in    */
+/* v = exp(-u) the integrand looks bounded on (0,1], but its slope   */
+/* grows like ln v at v = 0, and a fixed rule there is far off near  */
+/* saturation.)  Empirical distributions are summed over             */
+/* their bins (kept in increasing size), each bin being one priority */
+/* class.  Returns -1 when arrivals are not Poisson and MAXDOUBLE    */
+/* when the queue is unstable.  Times are in the units of the input  */
+/* parameters.                                                       */
+/*********************************************************************/
+double Analytic_sjf(struct Sim_parms *parms)
+  {
+  double lambda, rho, es, es2, w0, sum, top, sigma, prev, m, f0, fm, f1, *p;
+  struct Emp_dist *d;
+  int i, failed;
+  if(parms->rate_profile != NULL || parms->mmpp != NULL)
+         return(-1);
+  lambda = 1 / parms->iarrive_time;
+  if(parms->burst_dist == NULL)
+         {
+         es = parms->service_time;
+         rho = lambda * es;
+         if(rho >= 1)
+                return(MAXDOUBLE);
+         /* W0 = lambda * 2 es^2 / 2; past top the integrand is below */
+         /* exp(-u) / (1 - rho)^2, so the rest is under ANALYTIC_TOL   */
+         w0 = lambda * es * es;
+         top = log(1 / (ANALYTIC_TOL * (1 - rho) * (1 - rho)));
+         /* unit pieces first, so no bump can hide between the points */
+         failed = FALSE;
+         sum = 0;
+         f1 = Sjf_integrand(0, rho);
+         for(i = 0; i < (int) ceil(top); i++)
+                {
+                f0 = f1;
+                fm = Sjf_integrand(i + 0.5, rho);
+                f1 = Sjf_integrand(i + 1, rho);
+                sum += Sjf_simpson(i, i + 1, f0, fm, f1, (f0 + 4 * fm + f1) / 6,
+                                   ANALYTIC_TOL / ceil(top), ANALYTIC_DEPTH, rho, &failed);
+                }
+         sum += f1;
+         if(failed)
+                printf(" ***Warning - analytic integral did not reach its tolerance***\n");
+         return(es + w0 * sum);
+         }
+  /* empirical distribution - probability and moments of each bin */
+  d = parms->burst_dist;
+  p = (double *) malloc(d->nbins * sizeof(double));
+  Bin_probs(d, p);
+  es = 0;
+  es2 = 0;
+  for(i = 0; i < d->nbins; i++)
+         {
+         m = d->raw ? d->left[i] + d->width[i] / 2 : d->value[i];
+         es += p[i] * m;
+         es2 += p[i] * (m * m + (d->raw ? d->width[i] * d->width[i] / 12 : 0));
+         }
+  rho = lambda * es;
+  if(rho >= 1)
+         {
+         free(p);
+         return(MAXDOUBLE);
+         }
+  w0 = lambda * es2 / 2;
+  /* bins are in increasing size, so sigma is the load of shorter jobs */
+  sum = es;
+  sigma = 0;
+  for(i = 0; i < d->nbins; i++)
+         {
+         m = d->raw ? d->left[i] + d->width[i] / 2 : d->value[i];
+         prev = sigma;
+         sigma += lambda * p[i] * m;
+         if(p[i] > 0)
+                sum += p[i] * w0 / ((1 - prev) * (1 - sigma));
+         }
+  free(p);
+  return(sum);
+  }
+
+/*********************************************************************/
+/* Name: Sjf_integrand                                               */
+/* Description                                                       */
+/*    This function returns exp(-u) / (1 - rho(u))^2 for exponential */
+/* jobs, u being the job size over the mean, where the load of jobs  */
+/* no longer than u is rho(u) = rho (1 - exp(-u) (1 + u)).           */
+/*********************************************************************/
+double Sjf_integrand(double u, double rho)
+  {
+  double r;
+  r = rho * (-expm1(-u) - u * exp(-u));
+  return(exp(-u) / ((1 - r) * (1 - r)));
+  }
+
+/*********************************************************************/
+/* Name: Sjf_simpson                                                 */
+/* Description                                                       */
+/*    This function integrates Sjf_integrand over [a,b] by adaptive  */
+/* Simpson.  whole is Simpson's rule over the interval from fa, fm   */
+/* and fb; each half is redone and kept once the two halves agree    */
+/* with whole to within 15 tol, with Richardson's correction added.  */
+/* failed is set if depth runs out first.                            */
+/*********************************************************************/
+double Sjf_simpson(double a, double b, double fa, double fm, double fb, double whole,
+                   double tol, int depth, double rho, int *failed)
+  {
+  double m, fl, fr, left, right;
+  m = (a + b) / 2;
+  fl = Sjf_integrand((a + m) / 2, rho);
+  fr = Sjf_integrand((m + b) / 2, rho);
+  left = (m - a) / 6 * (fa + 4 * fl + fm);
+  right = (b - m) / 6 * (fm + 4 * fr + fb);
+  if(fabs(left + right - whole) <= 15 * tol)
+         return(left + right + (left + right - whole) / 15);
+  if(depth <= 0)
+         {
+         *failed = TRUE;
+         return(left + right);
+         }
+  return(Sjf_simpson(a, m, fa, fl, fm, left, tol / 2, depth - 1, rho, failed) +
+         Sjf_simpson(m, b, fm, fr, fb, right, tol / 2, depth - 1, rho, failed));
+  }
+
+/*********************************************************************/
+/* Name: Bin_probs                                                   */
+/* Description                                                       */
+/*    This procedure recovers the probability of every bin of an     */
+/* empirical distribution from its alias table: bin i keeps prob[i]  */
+/* of its own column and the rest of every column aliased to it.     */
+/*********************************************************************/
+void Bin_probs(struct Emp_dist *dist, double *p)
+  {
+  int j;
+  for(j = 0; j < dist->nbins; j++)
+         p[j] = dist->prob[j];
+  for(j = 0; j < dist->nbins; j++)
+         if(dist->alias[j] != j)
+                p[dist->alias[j]] += 1 - dist->prob[j];
+  for(j = 0; j < dist->nbins; j++)
+         p[j] /= dist->nbins;
+  }
+
+/*********************************************************************/
+/* Name: Check_analytic                                              */
+/* Description                                                       */
+/*    This procedure prints the analytic mean response time and, if  */
+/* sim_mean is not negative, flags a simulated mean that differs     */
+/* from it by more than the tolerance.                               */
+/*********************************************************************/
+void Check_analytic(struct Sim_parms *parms, double sim_mean)
+  {
+  double exact, err;
+  exact = Analytic_sjf(parms);
+  if(exact < 0)
+         {
+         if(sim_mean < 0)
+                printf(" ***Error - analytic solution needs Poisson arrivals***\n");
+         return;
+         }
+  if(exact == MAXDOUBLE)
+         {
+         printf(" analytic mean response time > unstable (load >= 1)\n");
+         return;
+         }
+  printf(" analytic mean response time > %-6.3f\n", exact);
+  if(sim_mean < 0)
+         return;
+  err = (sim_mean - exact) / exact;
+  if(fabs(err) > parms->check_tol)
+         printf(" ***Warning - simulated mean is %.1f%% from analytic value***\n",
+                100 * err);
+  }
+
+/*********************************************************************/
+/* Name: Control_variate                                             */
+/* Description                                                       */
+/*    This function returns the control variate estimate of the mean */
+/* of y from k observations (batch or replication means).  y is      */
+/* regressed on the controls x1 and, unless x2 is NULL, x2, whose    */
+/* true means mu1 and mu2 are known:                                 */
+/*     y = a + b1 (x1 - mu1) + b2 (x2 - mu2) + e                     */
+/* and the intercept a is the adjusted estimate.  half is set to the */
+/* half-width of its 95% confidence interval, from the residual      */
+/* variance with k - q - 1 degrees of freedom, or to -1 when there   */
+/* are too few observations.                                         */
+/*********************************************************************/
+double Control_variate(long int k, double *y, double *x1, double *x2,
+                       double mu1, double mu2, double *half)
+  {
+  double a[3][5], row[3], piv, f, rss, e;
+  long int i;
+  int q, n, r, c;
+  q = (x2 != NULL) ? 2 : 1;
+  n = q + 1;
+  *half = -1;
+  if(k <= n + 1)
+         return(0);
+  /* normal equations X'X b = X'y, with e0 beside them for (X'X)^-1 [0][0] */
+  memset(a, 0, sizeof(a));
+  for(i = 0; i < k; i++)
+         {
+         row[0] = 1;
+         row[1] = x1[i] - mu1;
+         row[2] = (q == 2) ? x2[i] - mu2 : 0;
+         for(r = 0; r < n; r++)
+                {
+                for(c = 0; c < n; c++)
+                       a[r][c] += row[r] * row[c];
+                a[r][n] += row[r] * y[i];
+                }
+         }
+  a[0][n+1] = 1;
+  /* Gauss-Jordan elimination, X'X is positive definite so no pivoting */
+  for(c = 0; c < n; c++)
+         {
+         piv = a[c][c];
+         if(fabs(piv) < 1e-300)
+                return(0);
+         for(r = 0; r < n; r++)
+                if(r != c)
+                       {
+                       f = a[r][c] / piv;
+                       a[r][n] -= f * a[c][n];
+                       a[r][n+1] -= f * a[c][n+1];
+                       for(i = c; i < n; i++)
+                              a[r][i] -= f * a[c][i];
+                       }
+         }
+  /* residual sum of squares */
+  rss = 0;
+  for(i = 0; i < k; i++)
+         {
+         e = y[i] - a[0][n] / a[0][0] - a[1][n] / a[1][1] * (x1[i] - mu1);
+         if(q == 2)
+                e -= a[2][n] / a[2][2] * (x2[i] - mu2);
+         rss += e * e;
+         }
+  *half = T_quantile(0.975, k - n) * sqrt(rss / (k - n) * a[0][n+1] / a[0][0]);
+  return(a[0][n] / a[0][0]);
+  }
+
+/*********************************************************************/
+/* Name: Burst_mean_ticks                                            */
+/* Description                                                       */
+/*    This function returns the true mean of a generated burst time  */
+/* in clock ticks.  Bursts are rounded up to a whole tick, so an     */
+/* exponential with mean m ticks has mean 1 / (1 - exp(-1/m)).  For  */
+/* empirical distributions the rounded value of every bin, or for    */
+/* raw samples the rounded uniform draw within it, is averaged over  */
+/* the bin probabilities the alias table samples with.               */
+/*********************************************************************/
+double Burst_mean_ticks(struct Sim_parms *parms)
+  {
+  struct Emp_dist *dist = parms->burst_dist;
+  double *p, sum;
+  int i;
+  if(dist == NULL)
+         return(1 / (1 - exp(-1 / (100.0 * parms->service_time))));
+  p = (double *) malloc(dist->nbins * sizeof(double));
+  if(p == NULL)
+         {
+         printf(" ***Error - out of memory***\n");
+         exit(1);
+         }
+  Bin_probs(dist, p);
+  sum = 0;
+  for(i = 0; i < dist->nbins; i++)
+         if(dist->raw)
+                sum += p[i] * Ceil_mean(100 * dist->left[i],
+                                        100 * (dist->left[i] + dist->width[i]));
+         else
+                sum += p[i] * ceil(dist->value[i] * 100);
+  free(p);
+  return(sum);
+  }
+
+/*********************************************************************/
+/* Name: Ceil_mean                                                   */
+/* Description                                                       */
+/*    This function returns the mean of ceil(t) for t uniform on     */
+/* [a, b].  The part above t is integrated piece by piece: over one  */
+/* whole tick it is 1/2, and over a fraction f of a tick f - f*f/2.  */
+/*********************************************************************/
+double Ceil_mean(double a, double b)
+  {
+  double na, nb, fa, fb;
+  if(b <= a)
+         return(ceil(a));
+  na = floor(a);
+  nb = floor(b);
+  fa = a - na;
+  fb = b - nb;
+  return((a + b) / 2 + ((nb - na) / 2 + fb - fb * fb / 2 - fa + fa * fa / 2) / (b - a));
+  }
+
+/*********************************************************************/
+/* Name: Iat_mean_ticks                                              */
+/* Description                                                       */
+/*    This function returns the true mean interarrival time in clock */
+/* ticks for Poisson arrivals (rounded up like bursts), or -1 when   */
+/* arrivals come from a profile or MMPP and no exact mean is known.  */
+/*********************************************************************/
+double Iat_mean_ticks(struct Sim_parms *parms)
+  {
+  if(parms->rate_profile != NULL || parms->mmpp != NULL)
+         return(-1);
+  return(1 / (1 - exp(-1 / (100.0 * parms->iarrive_time))));
+  }
+
+/*********************************************************************/
+/* Name: Print_control                                               */
+/* Description                                                       */
+/*    This procedure prints the control variate estimate of the mean */
+/* response time from k batch or replication means, using the burst  */
+/* time and, for Poisson arrivals, the interarrival time as controls.*/
+/* plain_half is the half-width without controls, in ticks, for the  */
+/* variance reduction.                                               */
+/*********************************************************************/
+void Print_control(struct Sim_parms *parms, long int k, double *y, double *x1, double *x2,
+                   double plain_half)
+  {
+  double mu2, est, half;
+  mu2 = Iat_mean_ticks(parms);
+  est = Control_variate(k, y, x1, (mu2 > 0) ? x2 : NULL, Burst_mean_ticks(parms), mu2, &half);
+  if(half < 0)
+         return;
+  printf(" control variate estimate ---> %-6.3f +/- %-6.3f\n", est / 100.0, half / 100.0);
+  if(half > 0)
+         printf(" control variance reduction -> %-6.3f\n",
+                plain_half * plain_half / (half * half));
+  }